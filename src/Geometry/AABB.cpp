@@ -1,30 +1,69 @@
-#include "AABB.h"
-
-#include <iostream>
-
-AABB::AABB() : AABB(-0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f) {}
-
-AABB::AABB(const glm::vec3 _min, const glm::vec3 _max) : minimum(_min), maximum(_max) {}
-
-AABB::AABB(const float minX, const float minY, const float minZ,
-		   const float maxX, const float maxY, const float maxZ) :
-	AABB(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ)) {}
-
-bool AABB::IsPointInsideAABB(const glm::vec3 & p) const {
-	if (p.x < minimum.x || p.y < minimum.y || p.z < minimum.z) {
-		return false;
-	}
-	if (p.x > maximum.x || p.y > maximum.y || p.z > maximum.z) {
-		return false;
-	}
-	return true;
-}
-
-glm::vec3 AABB::GetCenter() const { return 0.5f * (minimum + maximum); }
-
-bool AABB::RayIntersection(const Ray & ray) {
-	// Using the fast ray AABB overlap test using ray slopes as described by M. Eisemann et al.
-	// http://www.cg.cs.tu-bs.de/media/publications/fast-rayaxis-aligned-bounding-box-overlap-tests-using-ray-slopes.pdf
-	std::cerr << "AABB ray intersection has not been implemented yet (AABB.cpp)." << std::endl;
-	return false;
-}
+#include "AABB.h"
+
+namespace {
+	// Tests the ray projected onto the plane spanned by two axes a and b against the projected box.
+	// The projected ray is given by b = bbya * a + cab and a = abyb * b + cba.
+	// The ray misses if it has passed the box on one side when it leaves the box slab on the other axis.
+	inline bool SlopeTest(const float da, const float db,
+						  const float aMin, const float aMax, const float bMin, const float bMax,
+						  const float bbya, const float cab, const float abyb, const float cba) {
+		if (da == 0.0f || db == 0.0f) {
+			return true; // Handled by the origin tests.
+		}
+		const float b = bbya * (da < 0.0f ? aMin : aMax) + cab;
+		if (db < 0.0f ? b > bMax : b < bMin) {
+			return false;
+		}
+		const float a = abyb * (db < 0.0f ? bMin : bMax) + cba;
+		if (da < 0.0f ? a > aMax : a < aMin) {
+			return false;
+		}
+		return true;
+	}
+
+	// Returns false if the ray origin is on the wrong side of the box along a given axis.
+	inline bool OriginTest(const float d, const float o, const float min, const float max) {
+		if (d < 0.0f) {
+			return o >= min;
+		}
+		if (d > 0.0f) {
+			return o <= max;
+		}
+		return o >= min && o <= max;
+	}
+}
+
+AABB::AABB() : AABB(-0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f) {}
+
+AABB::AABB(const glm::vec3 _min, const glm::vec3 _max) : minimum(_min), maximum(_max) {}
+
+AABB::AABB(const float minX, const float minY, const float minZ,
+		   const float maxX, const float maxY, const float maxZ) :
+	AABB(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ)) {}
+
+bool AABB::IsPointInsideAABB(const glm::vec3 & p) const {
+	if (p.x < minimum.x || p.y < minimum.y || p.z < minimum.z) {
+		return false;
+	}
+	if (p.x > maximum.x || p.y > maximum.y || p.z > maximum.z) {
+		return false;
+	}
+	return true;
+}
+
+glm::vec3 AABB::GetCenter() const { return 0.5f * (minimum + maximum); }
+
+bool AABB::RayIntersection(const Ray & ray) const {
+	// Using the fast ray AABB overlap test using ray slopes as described by M. Eisemann et al.
+	// http://www.cg.cs.tu-bs.de/media/publications/fast-rayaxis-aligned-bounding-box-overlap-tests-using-ray-slopes.pdf
+	// The paper enumerates all 26 ray classifications (MMM, MMP, ...) explicitly, here the
+	// classification is instead given by the signs of the direction components.
+	const auto & d = ray.direction;
+	const auto & o = ray.from;
+	return OriginTest(d.x, o.x, minimum.x, maximum.x) &&
+		OriginTest(d.y, o.y, minimum.y, maximum.y) &&
+		OriginTest(d.z, o.z, minimum.z, maximum.z) &&
+		SlopeTest(d.x, d.y, minimum.x, maximum.x, minimum.y, maximum.y, ray.jbyi, ray.cxy, ray.ibyj, ray.cyx) &&
+		SlopeTest(d.x, d.z, minimum.x, maximum.x, minimum.z, maximum.z, ray.kbyi, ray.cxz, ray.ibyk, ray.czx) &&
+		SlopeTest(d.y, d.z, minimum.y, maximum.y, minimum.z, maximum.z, ray.kbyj, ray.cyz, ray.jbyk, ray.czy);
+}
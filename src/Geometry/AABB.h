@@ -1,29 +1,52 @@
-#pragma once
-
-#include <glm.hpp>
-
-#include "Ray.h"
-
-/// <summary> Describes an axis aligned bounding box. </summary>
-class AABB {
-public:
-	glm::vec3 minimum, maximum;
-
-	/// <summary> Creates an identity axis aligned cube. </summary>
-	AABB();
-
-	/// <summary> Constructs an AABB on the form (minimum, maximum). </summary>
-	AABB(const glm::vec3 minimum, const glm::vec3 maximum);
-
-	/// <summary> Constructs an AABB on the form ({minX, minY, minZ}, {maxX, maxY, maxZ}). </summary>
-	AABB(const float minX, const float minY, const float minZ, const float maxX, const float maxY, const float maxZ);
-
-	/// <summary> Returns true if the given point is inside this AABB. </summary>
-	bool IsPointInsideAABB(const glm::vec3 & point) const;
-
-	/// <summary> Returns the center of the AABB. </summary>
-	glm::vec3 GetCenter() const;
-
-	/// <summary> Returns true if a given ray intersects this AABB. </summary>
-	bool RayIntersection(const Ray & ray);
-};
\ No newline at end of file
+#pragma once
+
+#include <glm.hpp>
+
+#include "Ray.h"
+
+/// <summary> Describes an axis aligned bounding box. </summary>
+class AABB {
+public:
+	glm::vec3 minimum, maximum;
+
+	/// <summary> Creates an identity axis aligned cube. </summary>
+	AABB();
+
+	/// <summary> Constructs an AABB on the form (minimum, maximum). </summary>
+	AABB(const glm::vec3 minimum, const glm::vec3 maximum);
+
+	/// <summary> Constructs an AABB on the form ({minX, minY, minZ}, {maxX, maxY, maxZ}). </summary>
+	AABB(const float minX, const float minY, const float minZ, const float maxX, const float maxY, const float maxZ);
+
+	/// <summary> Returns true if the given point is inside this AABB. </summary>
+	bool IsPointInsideAABB(const glm::vec3 & point) const;
+
+	/// <summary> Returns the center of the AABB. </summary>
+	glm::vec3 GetCenter() const;
+
+	/// <summary> 
+	/// Returns true if a given ray intersects this AABB. 
+	/// The ray data must be up to date (see Ray::Update).
+	/// </summary>
+	bool RayIntersection(const Ray & ray) const;
+
+	/// <summary> 
+	/// Returns true if a given ray intersects this AABB closer than maxDistance.
+	/// Also computes the distance along the ray to where it enters the AABB (0 if the ray starts inside).
+	/// The ray data must be up to date (see Ray::Update).
+	/// </summary>
+	inline bool RayIntersection(const Ray & ray, const float maxDistance, float & entryDistance) const;
+};
+
+bool AABB::RayIntersection(const Ray & ray, const float maxDistance, float & entryDistance) const {
+	// Standard slab test. The exit distance is scaled up slightly to make the test conservative
+	// with respect to floating point errors (see Physically Based Rendering, 3rd ed., 3.9.2).
+	const glm::vec3 inverseDirection(ray.idirx, ray.idiry, ray.idirz);
+	const glm::vec3 t1 = (minimum - ray.from) * inverseDirection;
+	const glm::vec3 t2 = (maximum - ray.from) * inverseDirection;
+	const glm::vec3 tNear = glm::min(t1, t2);
+	const glm::vec3 tFar = glm::max(t1, t2);
+	entryDistance = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	const float exitDistance = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+	return entryDistance <= exitDistance * 1.0000004f;
+}
\ No newline at end of file
@@ -1,28 +1,59 @@
-#pragma once
-
-#include "glm.hpp"
-
-#include "AABB.h"
-#include "../Rendering/Materials/Material.h"
-#include "Ray.h"
-
-/// <summary> Abstract base class for geometrical primitives such as spheres and triangles </summary> 
-class Primitive {
-public:
-	bool convex = true;
-	bool enabled = true;
-	virtual glm::vec3 GetNormal(const glm::vec3 & position) const = 0;
-	virtual glm::vec3 GetCenter() const = 0;
-	virtual glm::vec3 GetRandomPositionOnSurface() const = 0;
-	virtual const AABB & GetAxisAlignedBoundingBox() const = 0;
-
-	/// <summary> 
-	/// Computes the ray intersection point.
-	/// Returns true if there is an intersection.
-	/// </summary>
-	/// <param name='ray'> The ray for which we compute intersection. </param>
-	/// <param name='intersectionPoint'> 
-	/// The distance to the intersection point (if there is an intersection). 
-	/// </param>
-	virtual bool RayIntersection(const Ray& ray, float & intersectionDistance) const = 0;
+#pragma once
+
+#include "glm.hpp"
+
+#include "AABB.h"
+#include "../Rendering/Materials/Material.h"
+#include "Ray.h"
+#include "../Utility/Random.h"
+#include "../Utility/Hash.h"
+
+/// <summary> Abstract base class for geometrical primitives such as spheres and triangles </summary> 
+class Primitive {
+public:
+	bool convex = true;
+	bool enabled = true;
+	virtual glm::vec3 GetNormal(const glm::vec3 & position) const = 0;
+	virtual glm::vec3 GetCenter() const = 0;
+	virtual const AABB & GetAxisAlignedBoundingBox() const = 0;
+
+	/// <summary> Returns the position on the surface given by a sample point u in [0, 1)^2. </summary>
+	virtual glm::vec3 GetPositionOnSurface(const glm::vec2 & u) const = 0;
+
+	/// <summary> Returns the surface area (e.g. to convert the emitted radiance of a light source into its power). </summary>
+	virtual float GetArea() const = 0;
+
+	/// <summary> Adds the type and the geometry of the primitive to a hash (used to identify scenes). </summary>
+	virtual void AddToHash(Utility::Hash & hash) const = 0;
+
+	/// <summary> Returns a random position on the surface. </summary>
+	glm::vec3 GetRandomPositionOnSurface(Utility::RandomGenerator & random) const {
+		const float u = random.NextFloat();
+		return GetPositionOnSurface(glm::vec2(u, random.NextFloat()));
+	}
+
+	/// <summary> 
+	/// Computes the ray intersection point.
+	/// Returns true if there is an intersection.
+	/// </summary>
+	/// <param name='ray'> The ray for which we compute intersection. </param>
+	/// <param name='intersectionPoint'> 
+	/// The distance to the intersection point (if there is an intersection). Only distances within (ray.tMin, ray.tMax) are reported.
+	/// </param>
+	virtual bool RayIntersection(const Ray& ray, float & intersectionDistance) const = 0;
+
+	/// <summary> The maximum number of intersections a ray can have with a single (convex) primitive. </summary>
+	static const unsigned int MAX_RAY_INTERSECTIONS = 2;
+
+	/// <summary> 
+	/// Computes all ray intersection points (closest first). Returns the number of intersections.
+	/// Primitives which can be hit more than once by the same ray (e.g. spheres) must override this.
+	/// </summary>
+	/// <param name='ray'> The ray for which we compute intersections. </param>
+	/// <param name='intersectionDistances'> 
+	/// OUT: The distances to the intersection points within (ray.tMin, ray.tMax).
+	/// </param>
+	virtual unsigned int RayIntersections(const Ray& ray, float intersectionDistances[MAX_RAY_INTERSECTIONS]) const {
+		return RayIntersection(ray, intersectionDistances[0]) ? 1 : 0;
+	}
 };
\ No newline at end of file
@@ -1,14 +1,34 @@
-#include "Ray.h"
-
-#include <iostream>
-
-Ray::Ray(glm::vec3 _from, glm::vec3 _dir) :
-	from(_from), direction(_dir) {}
-
-Ray::Ray() { }
-
-#if __AABB_TESTING
-void Ray::Update() {
-	std::cerr << "Ray AABB update has not been implemented yet (Ray.cpp)." << std::endl;
-}
-#endif
\ No newline at end of file
+#include "Ray.h"
+
+Ray::Ray(glm::vec3 _from, glm::vec3 _dir, float _tMin, float _tMax) :
+	from(_from), direction(_dir), tMin(_tMin), tMax(_tMax) {
+	Update();
+}
+
+Ray::Ray() : Ray(glm::vec3(0), glm::vec3(1, 0, 0)) { }
+
+void Ray::Update() {
+	const float i = direction.x;
+	const float j = direction.y;
+	const float k = direction.z;
+
+	idirx = 1.0f / i;
+	idiry = 1.0f / j;
+	idirz = 1.0f / k;
+
+	// Slopes. These are only used for axes where both direction components are non-zero.
+	ibyj = i * idiry;
+	jbyi = j * idirx;
+	jbyk = j * idirz;
+	kbyj = k * idiry;
+	ibyk = i * idirz;
+	kbyi = k * idirx;
+
+	// Line constants, e.g. the projected ray in the xy-plane is given by y = jbyi * x + cxy.
+	cxy = from.y - jbyi * from.x;
+	cxz = from.z - kbyi * from.x;
+	cyx = from.x - ibyj * from.y;
+	cyz = from.z - kbyj * from.y;
+	czx = from.x - ibyk * from.z;
+	czy = from.y - jbyk * from.z;
+}
\ No newline at end of file
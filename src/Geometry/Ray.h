@@ -1,30 +1,32 @@
-#pragma once
-
-#include <glm.hpp>
-
-#define __AABB_TESTING false
-
-/// <summary> 
-/// Describes a 3D ray. 
-/// Ray is parametrized as X = F + t * D (where F = from and D = direction).
-/// </summary>
-class Ray {
-public:
-	glm::vec3 direction, from;
-	Ray(glm::vec3 from, glm::vec3 direction);
-	Ray();
-#if __AABB_TESTING
-	/// <summary> 
-	/// Updates ray AABB intersection testing data. This should be called whenever the ray is altered.
-	/// </summary>
-	void Update();
-
-	// ------------------------------------------------------
-	// Extra data needed for fast AAABB intersection testing.
-	// ------------------------------------------------------
-	float idirx, idiry, idirz; // TODO: Change name of these to something more intuitive.
-	float cxy, cxz, cyx, cyz, czx, czy; // TODO: Change name of these to something more intuitive.
-	float ibyj, jbyi, jbyk, kbyj, ibyk, kbyi; // TODO: Change name of these to something more intuitive.
-	// ------------------------------------------------------
-#endif
+#pragma once
+
+#include <cfloat>
+
+#include <glm.hpp>
+
+/// <summary> 
+/// Describes a 3D ray. 
+/// Ray is parametrized as X = F + t * D (where F = from and D = direction).
+/// Only intersections with tMin < t < tMax are considered.
+/// </summary>
+class Ray {
+public:
+	glm::vec3 direction, from;
+	float tMin, tMax;
+	Ray(glm::vec3 from, glm::vec3 direction, float tMin = FLT_EPSILON, float tMax = FLT_MAX);
+	Ray();
+
+	/// <summary> 
+	/// Updates ray AABB intersection testing data. This should be called whenever the ray is altered.
+	/// </summary>
+	void Update();
+
+	// ------------------------------------------------------
+	// Extra data needed for fast AABB intersection testing.
+	// Naming follows the ray slope paper by M. Eisemann et al. (see AABB.cpp).
+	// ------------------------------------------------------
+	float idirx, idiry, idirz; // Inverse direction.
+	float cxy, cxz, cyx, cyz, czx, czy; // Line constants of the ray projected onto the xy, xz and yz planes.
+	float ibyj, jbyi, jbyk, kbyj, ibyk, kbyi; // Slopes (i, j, k is the direction along x, y, z).
+	// ------------------------------------------------------
 };
\ No newline at end of file
@@ -1,51 +1,82 @@
-#include "Sphere.h"
-
-#include <iostream>
-#include "../Utility/Math.h"
-#include "../../includes/glm/gtx/intersect.hpp"
-
-#define __BACK_FACE_CULLING false
-
-using namespace glm;
-
-Sphere::Sphere(vec3 _center, float _radius) :
-	Primitive(), center(_center), radius(_radius) {
-	glm::vec3 minimum(center.x - radius, center.y - radius, center.z - radius);
-	glm::vec3 maximum(center.x + radius, center.y + radius, center.z + radius);
-	axisAlignedBoundingBox = AABB(minimum, maximum);
-}
-
-glm::vec3 Sphere::GetNormal(const glm::vec3 & position) const { return glm::normalize(position - center); }
-
-glm::vec3 Sphere::GetCenter() const { return center; }
-
-glm::vec3 Sphere::GetRandomPositionOnSurface() const {
-	int direction = (rand() & 1) == 0 ? -1 : 1;
-	return center + radius * Utility::Math::CosineWeightedHemisphereSampleDirection(glm::vec3(0, 0, direction));
-}
-
-const AABB & Sphere::GetAxisAlignedBoundingBox() const {
-	return axisAlignedBoundingBox;
-}
-
-bool Sphere::RayIntersection(const Ray & ray, float & intersectionDistance) const {
-#if __BACK_FACE_CULLING
-	if (dot(-ray.direction, GetNormal(ray.from)) < FLT_EPSILON) {
-		return false;
-	}
-#endif // __BACK_FACE_CULLING
-	const vec3 m = ray.from - center;
-	float u = 2 * glm::dot(m, ray.direction);
-	float v = glm::dot(m, m) - radius * radius;
-	float d = 0.25f * u * u - v;
-	if (d < FLT_EPSILON) {
-		return false;
-	}
-	d = sqrt(d);
-	float t1 = -0.5f * u + d;
-	float t2 = -0.5f * u - d;
-	if (t1 < FLT_EPSILON) { t1 = t2; }
-	if (t2 < FLT_EPSILON) { t2 = t1; }
-	intersectionDistance = glm::min<float>(t1, t2);
-	return intersectionDistance > FLT_EPSILON;
-}
+#include "Sphere.h"
+
+#include <iostream>
+#include "../Utility/Math.h"
+#include "../../includes/glm/gtx/intersect.hpp"
+
+#define __BACK_FACE_CULLING false
+
+using namespace glm;
+
+Sphere::Sphere(vec3 _center, float _radius) :
+	Primitive(), center(_center), radius(_radius) {
+	glm::vec3 minimum(center.x - radius, center.y - radius, center.z - radius);
+	glm::vec3 maximum(center.x + radius, center.y + radius, center.z + radius);
+	axisAlignedBoundingBox = AABB(minimum, maximum);
+}
+
+glm::vec3 Sphere::GetNormal(const glm::vec3 & position) const { return glm::normalize(position - center); }
+
+glm::vec3 Sphere::GetCenter() const { return center; }
+
+void Sphere::AddToHash(Utility::Hash & hash) const {
+	hash.Add("Sphere");
+	hash.Add(center);
+	hash.Add(radius);
+}
+
+glm::vec3 Sphere::GetPositionOnSurface(const glm::vec2 & u) const {
+	// The first half of [0, 1) selects the lower hemisphere and the second half the upper one.
+	const int direction = u.x < 0.5f ? -1 : 1;
+	const float hemisphereU = u.x < 0.5f ? 2.0f * u.x : 2.0f * u.x - 1.0f;
+	return center + radius * Utility::Math::CosineWeightedHemisphereSampleDirection(glm::vec3(0, 0, direction), glm::vec2(hemisphereU, u.y));
+}
+
+float Sphere::GetArea() const {
+	return 4.0f * glm::pi<float>() * radius * radius;
+}
+
+const AABB & Sphere::GetAxisAlignedBoundingBox() const {
+	return axisAlignedBoundingBox;
+}
+
+bool Sphere::RayIntersection(const Ray & ray, float & intersectionDistance) const {
+#if __BACK_FACE_CULLING
+	if (dot(-ray.direction, GetNormal(ray.from)) < FLT_EPSILON) {
+		return false;
+	}
+#endif // __BACK_FACE_CULLING
+	const vec3 m = ray.from - center;
+	float u = 2 * glm::dot(m, ray.direction);
+	float v = glm::dot(m, m) - radius * radius;
+	float d = 0.25f * u * u - v;
+	if (d < FLT_EPSILON) {
+		return false;
+	}
+	d = sqrt(d);
+	float t1 = -0.5f * u + d;
+	float t2 = -0.5f * u - d;
+	if (t1 < ray.tMin) { t1 = t2; }
+	if (t2 < ray.tMin) { t2 = t1; }
+	intersectionDistance = glm::min<float>(t1, t2);
+	return intersectionDistance > ray.tMin && intersectionDistance < ray.tMax;
+}
+
+unsigned int Sphere::RayIntersections(const Ray & ray, float intersectionDistances[MAX_RAY_INTERSECTIONS]) const {
+	const vec3 m = ray.from - center;
+	float u = 2 * glm::dot(m, ray.direction);
+	float v = glm::dot(m, m) - radius * radius;
+	float d = 0.25f * u * u - v;
+	if (d < FLT_EPSILON) {
+		return 0;
+	}
+	d = sqrt(d);
+	const float t[2] = { -0.5f * u - d, -0.5f * u + d };
+	unsigned int count = 0;
+	for (const float ti : t) {
+		if (ti > ray.tMin && ti < ray.tMax) {
+			intersectionDistances[count++] = ti;
+		}
+	}
+	return count;
+}
@@ -1,6 +1,69 @@
 #include "Photon.h"
 
+#include <cmath>
+
 Photon::Photon() {}
 
-Photon::Photon(glm::vec3 _position, glm::vec3 _direction, glm::vec3 _color, Primitive * _prim) :
-	position(_position), direction(_direction), color(_color), primitive(_prim) {}
+Photon::Photon(const glm::vec3 & _position, const glm::vec3 & _direction, const glm::vec3 & _color, const glm::vec3 & _normal) :
+	position(_position) {
+	EncodeUnitVector(_direction, direction);
+	EncodeUnitVector(_normal, normal);
+	SetColor(_color);
+}
+
+glm::vec3 Photon::GetDirection() const {
+	return DecodeUnitVector(direction);
+}
+
+glm::vec3 Photon::GetNormal() const {
+	return DecodeUnitVector(normal);
+}
+
+void Photon::SetColor(const glm::vec3 & _color) {
+	const float maxComponent = glm::max(_color.r, glm::max(_color.g, _color.b));
+	if (maxComponent < 1e-32f) {
+		color[0] = color[1] = color[2] = color[3] = 0;
+		return;
+	}
+
+	// The largest component gets a mantissa in [128, 256), rounded to the nearest value.
+	int exponent;
+	std::frexp(maxComponent, &exponent);
+	const float scale = std::ldexp(256.0f, -exponent);
+	for (unsigned int i = 0; i < 3; ++i) {
+		color[i] = static_cast<unsigned char>(glm::min(255.0f, glm::max(0.0f, _color[i]) * scale + 0.5f));
+	}
+	color[3] = static_cast<unsigned char>(exponent + 128);
+}
+
+glm::vec3 Photon::GetColor() const {
+	if (color[3] == 0) {
+		return glm::vec3(0.0f);
+	}
+	const float scale = std::ldexp(1.0f, color[3] - (128 + 8));
+	return scale * glm::vec3(color[0], color[1], color[2]);
+}
+
+void Photon::EncodeUnitVector(const glm::vec3 & v, unsigned char encoded[2]) {
+	// Project onto the octahedron |x| + |y| + |z| = 1, and fold the lower half over the diagonals.
+	const glm::vec3 p = v / (std::abs(v.x) + std::abs(v.y) + std::abs(v.z));
+	glm::vec2 e(p.x, p.y);
+	if (p.z < 0.0f) {
+		e.x = (1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f);
+		e.y = (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	// An odd number of steps is used, so that 0 (and thereby the coordinate axes) is represented exactly.
+	encoded[0] = static_cast<unsigned char>(glm::clamp(e.x * 127.0f + 127.5f, 0.0f, 254.0f));
+	encoded[1] = static_cast<unsigned char>(glm::clamp(e.y * 127.0f + 127.5f, 0.0f, 254.0f));
+}
+
+glm::vec3 Photon::DecodeUnitVector(const unsigned char encoded[2]) {
+	const float x = encoded[0] * (1.0f / 127.0f) - 1.0f;
+	const float y = encoded[1] * (1.0f / 127.0f) - 1.0f;
+	glm::vec3 v(x, y, 1.0f - std::abs(x) - std::abs(y));
+	if (v.z < 0.0f) {
+		v.x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		v.y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return glm::normalize(v);
+}
@@ -2,22 +2,45 @@
 
 #include <glm.hpp>
 
-#include "../Geometry/Primitive.h"
-
+/// <summary>
+/// A compact photon record of 20 bytes (compare Jensen, "Realistic Image Synthesis Using Photon Mapping", 2001).
+/// The position is stored as floats, the color as RGBE (8 bit mantissas with a shared exponent), and the incoming
+/// direction and the surface normal as octahedral unit vectors with 8 bits per component.
+/// The surface normal is stored so that gathers never need to look at the primitive the photon landed on.
+/// </summary>
 class Photon {
 public:
 	Photon();
-	Photon(glm::vec3 position, glm::vec3 direction, glm::vec3 color, Primitive* primitive);
-
-	/// <summary> The direction from where the photon came. </summary>
-	glm::vec3 direction;
+	Photon(const glm::vec3 & position, const glm::vec3 & direction, const glm::vec3 & color, const glm::vec3 & normal);
 
 	/// <summary> The world position of the photon. </summary>
 	glm::vec3 position;
 
-	/// <summary> The color of the photon. </summary>
-	glm::vec3 color;
+	/// <summary> Returns the direction from where the photon came. </summary>
+	glm::vec3 GetDirection() const;
+
+	/// <summary> Returns the color of the photon. </summary>
+	glm::vec3 GetColor() const;
+
+	/// <summary> Sets the color of the photon. </summary>
+	void SetColor(const glm::vec3 & color);
+
+	/// <summary> Returns the normal of the surface which the photon is placed on. </summary>
+	glm::vec3 GetNormal() const;
+
+private:
+	/// <summary> The color as RGBE. </summary>
+	unsigned char color[4];
+
+	/// <summary> The direction from where the photon came, octahedral encoded. </summary>
+	unsigned char direction[2];
+
+	/// <summary> The surface normal, octahedral encoded. </summary>
+	unsigned char normal[2];
+
+	/// <summary> Encodes a unit vector as two bytes using the octahedral mapping. </summary>
+	static void EncodeUnitVector(const glm::vec3 & v, unsigned char encoded[2]);
 
-	/// <summary> The primitive which the photon is placed on. </summary>
-	Primitive* primitive;
-};
\ No newline at end of file
+	/// <summary> Decodes a unit vector encoded by EncodeUnitVector. </summary>
+	static glm::vec3 DecodeUnitVector(const unsigned char encoded[2]);
+};
@@ -0,0 +1,94 @@
+#include "PhotonGuidingDistribution.h"
+
+#include <algorithm>
+
+#include "../../includes/glm/gtc/constants.hpp"
+
+#include "PhotonMap.h"
+#include "../Utility/Math.h"
+#include "../Rendering/RenderingConstants.h"
+
+PhotonGuidingDistribution::PhotonGuidingDistribution(const PhotonMap & photonMap, const glm::vec3 & position, const glm::vec3 & _normal,
+													 const unsigned int PHOTON_COUNT, const float MAX_RADIUS) : normal(_normal) {
+	tangent = glm::normalize(glm::cross(normal, Utility::Math::NonParallellVector(normal)));
+	bitangent = glm::cross(normal, tangent);
+
+	// Add the power of every photon to the cell which it arrived through.
+	std::fill(probabilities, probabilities + CELL_COUNT, 0.0f);
+	float powerSum = 0.0f;
+	NearestPhotons nearest;
+	for (unsigned int pass = 0; pass < 2; ++pass) {
+		if (pass == 0) {
+			photonMap.GetNearestDirectPhotonsAtPosition(position, PHOTON_COUNT, nearest, MAX_RADIUS);
+		}
+		else {
+			photonMap.GetNearestIndirectPhotonsAtPosition(position, PHOTON_COUNT, nearest, MAX_RADIUS);
+		}
+		for (unsigned int i = 0; i < nearest.count; ++i) {
+			const Photon & photon = *nearest.entries[i].photon;
+			const glm::vec3 incomingDirection = -photon.GetDirection();
+			if (glm::dot(photon.GetNormal(), normal) < __MIN_NORMAL_SIMILARITY || glm::dot(incomingDirection, normal) <= 0.0f) {
+				continue;
+			}
+			const glm::vec3 color = photon.GetColor();
+			const float power = color.r + color.g + color.b;
+			probabilities[GetCellIndex(incomingDirection)] += power;
+			powerSum += power;
+		}
+	}
+	if (powerSum <= 0.0f) {
+		return;
+	}
+
+	hasPhotons = true;
+	float cumulativeProbability = 0.0f;
+	for (unsigned int i = 0; i < CELL_COUNT; ++i) {
+		probabilities[i] /= powerSum;
+		cumulativeProbability += probabilities[i];
+		cumulativeProbabilities[i] = cumulativeProbability;
+	}
+	cumulativeProbabilities[CELL_COUNT - 1] = 1.0f;
+}
+
+glm::vec3 PhotonGuidingDistribution::Sample(const float choice, const glm::vec2 & u, float & weight) const {
+	if (!hasPhotons) {
+		weight = 1.0f;
+		return Utility::Math::CosineWeightedHemisphereSampleDirection(normal, u);
+	}
+
+	glm::vec3 direction;
+	if (choice < GUIDED_FRACTION) {
+		// Choose a cell by its probability, and reuse the position of u.x within the cell's range for the polar angle.
+		const unsigned int cell = static_cast<unsigned int>(
+			std::upper_bound(cumulativeProbabilities, cumulativeProbabilities + CELL_COUNT - 1, u.x) - cumulativeProbabilities);
+		const float rangeStart = cell == 0 ? 0.0f : cumulativeProbabilities[cell - 1];
+		const float v = glm::clamp((u.x - rangeStart) / std::max(probabilities[cell], FLT_MIN), 0.0f, 1.0f - FLT_EPSILON);
+
+		// Sample the cell uniformly in (sin^2(theta), phi), which is cosine-weighted within the cell.
+		const float sinThetaSquared = (cell / PHI_CELLS + v) / THETA_CELLS;
+		const float phi = glm::two_pi<float>() * (cell % PHI_CELLS + u.y) / PHI_CELLS;
+		const float sinTheta = std::sqrt(sinThetaSquared);
+		direction = glm::normalize(sinTheta * std::cos(phi) * tangent + sinTheta * std::sin(phi) * bitangent +
+								   std::sqrt(1.0f - sinThetaSquared) * normal);
+	}
+	else {
+		direction = Utility::Math::CosineWeightedHemisphereSampleDirection(normal, u);
+	}
+
+	// Every cell covers 1 / CELL_COUNT of the cosine lobe, so the pdf of the direction relative to the cosine-weighted pdf
+	// is the mix of 1 (for the cosine lobe) and the cell's probability times CELL_COUNT (for the photon cells).
+	const float relativePdf = (1.0f - GUIDED_FRACTION) + GUIDED_FRACTION * CELL_COUNT * probabilities[GetCellIndex(direction)];
+	weight = 1.0f / relativePdf;
+	return direction;
+}
+
+unsigned int PhotonGuidingDistribution::GetCellIndex(const glm::vec3 & direction) const {
+	const float cosTheta = glm::clamp(glm::dot(direction, normal), 0.0f, 1.0f);
+	const unsigned int thetaCell = std::min(static_cast<unsigned int>((1.0f - cosTheta * cosTheta) * THETA_CELLS), THETA_CELLS - 1);
+	float phi = std::atan2(glm::dot(direction, bitangent), glm::dot(direction, tangent));
+	if (phi < 0.0f) {
+		phi += glm::two_pi<float>();
+	}
+	const unsigned int phiCell = std::min(static_cast<unsigned int>(phi / glm::two_pi<float>() * PHI_CELLS), PHI_CELLS - 1);
+	return thetaCell * PHI_CELLS + phiCell;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm.hpp>
+
+class PhotonMap;
+
+/// <summary>
+/// A distribution of the directions which light arrives from at a surface point, built from the incoming directions
+/// of the nearest direct and indirect photons (Jensen, "Importance Driven Path Tracing using the Photon Map", 1995).
+/// The hemisphere is split into cells of equal cosine-weighted solid angle, and every cell gets the power of the photons
+/// which arrived through it. Directions are drawn from the cells or from the cosine lobe, so that directions where
+/// no photons arrived are still sampled.
+/// </summary>
+class PhotonGuidingDistribution {
+public:
+	/// <param name='photonMap'> The photon map whose photons guide the sampling. </param>
+	/// <param name='position'> The surface point. </param>
+	/// <param name='normal'> The surface normal at the point. </param>
+	/// <param name='PHOTON_COUNT'> The number of direct and of indirect photons used (at most NearestPhotons::MAX_COUNT). </param>
+	/// <param name='MAX_RADIUS'> The largest distance at which photons are used. </param>
+	PhotonGuidingDistribution(const PhotonMap & photonMap, const glm::vec3 & position, const glm::vec3 & normal,
+							  const unsigned int PHOTON_COUNT, const float MAX_RADIUS);
+
+	/// <summary>
+	/// Returns a direction in the hemisphere, drawn from the photon cells with probability GUIDED_FRACTION
+	/// (if any photons were found) and from the cosine lobe otherwise.
+	/// The weight is the cosine-weighted pdf divided by the pdf of the returned direction. Multiplying an estimate which
+	/// assumes cosine-weighted directions by the weight keeps it unbiased.
+	/// </summary>
+	/// <param name='choice'> A sample in [0, 1) which chooses between the photon cells and the cosine lobe. </param>
+	/// <param name='u'> A sample point in [0, 1)^2 which chooses the direction. </param>
+	/// <param name='weight'> Set to the weight of the returned direction. </param>
+	glm::vec3 Sample(const float choice, const glm::vec2 & u, float & weight) const;
+
+private:
+	/// <summary> The cells split sin^2(theta) into THETA_CELLS and phi into PHI_CELLS equal parts. </summary>
+	static const unsigned int THETA_CELLS = 4, PHI_CELLS = 8, CELL_COUNT = THETA_CELLS * PHI_CELLS;
+	const float GUIDED_FRACTION = 0.5f;
+
+	glm::vec3 normal, tangent, bitangent;
+
+	/// <summary> The probability of every cell, and the cumulative probabilities. </summary>
+	float probabilities[CELL_COUNT];
+	float cumulativeProbabilities[CELL_COUNT];
+	bool hasPhotons = false;
+
+	/// <summary> Returns the index of the cell which contains a direction in the hemisphere. </summary>
+	unsigned int GetCellIndex(const glm::vec3 & direction) const;
+};
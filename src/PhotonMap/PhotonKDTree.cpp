@@ -0,0 +1,294 @@
+#include "PhotonKDTree.h"
+
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <cassert>
+
+#include "../../includes/glm/gtx/norm.hpp"
+
+#define __PARALLEL_BUILD_MIN_PHOTONS 10000 // Subtrees with fewer photons than this are always built on the current thread.
+
+void PhotonKDTree::Build(const std::vector<Photon> & photons) {
+	nodeStorage.resize(photons.size());
+	splitAxisStorage.resize(photons.size());
+	nodes = nodeStorage.data();
+	splitAxes = splitAxisStorage.data();
+	size = static_cast<unsigned int>(photons.size());
+	if (photons.empty()) {
+		return;
+	}
+
+	// Build one subtree per hardware thread (roughly).
+	unsigned int parallelDepth = 0;
+	while ((1u << parallelDepth) < std::thread::hardware_concurrency()) {
+		++parallelDepth;
+	}
+	std::vector<Photon> workingPhotons(photons);
+	BuildSubtree(workingPhotons, 0, static_cast<unsigned int>(workingPhotons.size()), 0, parallelDepth);
+}
+
+void PhotonKDTree::Attach(const Photon * _nodes, const unsigned char * _splitAxes, const unsigned int _size) {
+	nodeStorage.clear();
+	splitAxisStorage.clear();
+	nodes = _nodes;
+	splitAxes = _splitAxes;
+	size = _size;
+}
+
+void PhotonKDTree::BuildSubtree(std::vector<Photon> & photons, const unsigned int first, const unsigned int last,
+								const unsigned int node, const unsigned int parallelDepth) {
+	const unsigned int size = last - first;
+	if (size == 1) {
+		nodeStorage[node] = photons[first];
+		splitAxisStorage[node] = 0;
+		return;
+	}
+
+	// Split along the axis with the largest extent.
+	glm::vec3 minimum = photons[first].position, maximum = photons[first].position;
+	for (unsigned int i = first + 1; i < last; ++i) {
+		minimum = glm::min(minimum, photons[i].position);
+		maximum = glm::max(maximum, photons[i].position);
+	}
+	const glm::vec3 extent = maximum - minimum;
+	const unsigned char axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+	// The median is chosen so that the left subtree is complete except for its last level, which keeps the tree left-balanced.
+	const unsigned int median = first + LeftSubtreeSize(size);
+	std::nth_element(photons.begin() + first, photons.begin() + median, photons.begin() + last,
+					 [axis](const Photon & a, const Photon & b) { return a.position[axis] < b.position[axis]; });
+	nodeStorage[node] = photons[median];
+	splitAxisStorage[node] = axis;
+
+	// The subtrees cover disjoint photon ranges and nodes, so they can be built simultaneously.
+	const bool hasRightSubtree = median + 1 < last;
+	if (parallelDepth > 0 && size >= __PARALLEL_BUILD_MIN_PHOTONS) {
+		std::thread leftBuilder(&PhotonKDTree::BuildSubtree, this, std::ref(photons), first, median, 2 * node + 1, parallelDepth - 1);
+		if (hasRightSubtree) {
+			BuildSubtree(photons, median + 1, last, 2 * node + 2, parallelDepth - 1);
+		}
+		leftBuilder.join();
+	}
+	else {
+		BuildSubtree(photons, first, median, 2 * node + 1, 0);
+		if (hasRightSubtree) {
+			BuildSubtree(photons, median + 1, last, 2 * node + 2, 0);
+		}
+	}
+}
+
+unsigned int PhotonKDTree::LeftSubtreeSize(const unsigned int size) {
+	// Find the number of nodes on the last (possibly incomplete) level of the tree.
+	unsigned int lastLevelCapacity = 1;
+	while (2 * lastLevelCapacity <= size) {
+		lastLevelCapacity *= 2;
+	}
+	const unsigned int lastLevelSize = size - (lastLevelCapacity - 1);
+
+	// The left subtree gets the complete levels of its half, and as much of the last level as fits in its half.
+	return (lastLevelCapacity / 2 - 1) + std::min(lastLevelSize, lastLevelCapacity / 2);
+}
+
+void PhotonKDTree::FindWithinRadius(const glm::vec3 & position, const float radius, std::vector<Photon> & photonsInRadius) const {
+	if (size == 0) {
+		return;
+	}
+	const float radiusSquared = radius * radius;
+
+	// Nodes which remain to be visited. The far child of a node is only visited if the sphere crosses the splitting plane.
+	unsigned int stack[2 * MAX_DEPTH];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const unsigned int node = stack[--stackSize];
+		const Photon & photon = nodes[node];
+		if (glm::distance2(photon.position, position) <= radiusSquared) {
+			photonsInRadius.push_back(photon);
+		}
+
+		const unsigned int left = 2 * node + 1;
+		if (left >= size) {
+			continue;
+		}
+		const unsigned int axis = splitAxes[node];
+		const float planeDistance = position[axis] - photon.position[axis];
+		const unsigned int right = left + 1;
+		if (planeDistance < 0) {
+			if (right < size && planeDistance * planeDistance <= radiusSquared) {
+				stack[stackSize++] = right;
+			}
+			stack[stackSize++] = left;
+		}
+		else {
+			if (planeDistance * planeDistance <= radiusSquared) {
+				stack[stackSize++] = left;
+			}
+			if (right < size) {
+				stack[stackSize++] = right;
+			}
+		}
+	}
+}
+
+unsigned int PhotonKDTree::CountWithinRadius(const glm::vec3 & position, const float radius, const unsigned int maxCount) const {
+	if (size == 0 || maxCount == 0) {
+		return 0;
+	}
+	const float radiusSquared = radius * radius;
+
+	// Same traversal as FindWithinRadius.
+	unsigned int count = 0;
+	unsigned int stack[2 * MAX_DEPTH];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const unsigned int node = stack[--stackSize];
+		const Photon & photon = nodes[node];
+		if (glm::distance2(photon.position, position) <= radiusSquared && ++count == maxCount) {
+			return count;
+		}
+
+		const unsigned int left = 2 * node + 1;
+		if (left >= size) {
+			continue;
+		}
+		const unsigned int axis = splitAxes[node];
+		const float planeDistance = position[axis] - photon.position[axis];
+		const unsigned int right = left + 1;
+		if (planeDistance < 0) {
+			if (right < size && planeDistance * planeDistance <= radiusSquared) {
+				stack[stackSize++] = right;
+			}
+			stack[stackSize++] = left;
+		}
+		else {
+			if (planeDistance * planeDistance <= radiusSquared) {
+				stack[stackSize++] = left;
+			}
+			if (right < size) {
+				stack[stackSize++] = right;
+			}
+		}
+	}
+	return count;
+}
+
+const Photon * PhotonKDTree::FindNearest(const glm::vec3 & position, const float radius) const {
+	if (size == 0) {
+		return nullptr;
+	}
+	const Photon * nearest = nullptr;
+	float nearestDistanceSquared = radius * radius;
+
+	// Nodes which remain to be visited, together with the squared distance to the splitting plane which separates them from the position.
+	struct StackEntry {
+		unsigned int node;
+		float planeDistanceSquared;
+	};
+	StackEntry stack[2 * MAX_DEPTH];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = { 0, 0.0f };
+	while (stackSize > 0) {
+		const StackEntry entry = stack[--stackSize];
+		if (entry.planeDistanceSquared > nearestDistanceSquared) {
+			continue;
+		}
+		const Photon & photon = nodes[entry.node];
+		const float distanceSquared = glm::distance2(photon.position, position);
+		if (distanceSquared <= nearestDistanceSquared) {
+			nearest = &photon;
+			nearestDistanceSquared = distanceSquared;
+		}
+
+		const unsigned int left = 2 * entry.node + 1;
+		if (left >= size) {
+			continue;
+		}
+		const unsigned int axis = splitAxes[entry.node];
+		const float planeDistance = position[axis] - photon.position[axis];
+		const unsigned int nearChild = planeDistance < 0 ? left : left + 1;
+		const unsigned int farChild = planeDistance < 0 ? left + 1 : left;
+
+		// Visit the near child first (it is pushed last).
+		if (farChild < size) {
+			stack[stackSize++] = { farChild, planeDistance * planeDistance };
+		}
+		if (nearChild < size) {
+			stack[stackSize++] = { nearChild, 0.0f };
+		}
+	}
+	return nearest;
+}
+
+void PhotonKDTree::FindNearestK(const glm::vec3 & position, const unsigned int k, NearestPhotons & nearest, const float maxRadius) const {
+	assert(k <= NearestPhotons::MAX_COUNT);
+	nearest.count = 0;
+	nearest.radiusSquared = maxRadius * maxRadius;
+	if (size == 0 || k == 0) {
+		return;
+	}
+	// Ordering the nearer photons first makes std::make_heap keep the farthest one at the top.
+	const auto nearer = [](const NearestPhotons::Entry & a, const NearestPhotons::Entry & b) { return a.distanceSquared < b.distanceSquared; };
+
+	// Same traversal as FindNearest. Once k photons are found, the search radius shrinks to the farthest of them,
+	// which is kept at the top of the heap.
+	struct StackEntry {
+		unsigned int node;
+		float planeDistanceSquared;
+	};
+	StackEntry stack[2 * MAX_DEPTH];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = { 0, 0.0f };
+	while (stackSize > 0) {
+		const StackEntry entry = stack[--stackSize];
+		if (entry.planeDistanceSquared > nearest.radiusSquared) {
+			continue;
+		}
+		const Photon & photon = nodes[entry.node];
+		const float distanceSquared = glm::distance2(photon.position, position);
+		if (distanceSquared <= nearest.radiusSquared) {
+			if (nearest.count < k) {
+				nearest.entries[nearest.count++] = { distanceSquared, &photon };
+				if (nearest.count == k) {
+					std::make_heap(nearest.entries, nearest.entries + k, nearer);
+					nearest.radiusSquared = nearest.entries[0].distanceSquared;
+				}
+			}
+			else {
+				// Replace the farthest photon, and sift the new one down to its place in the heap.
+				unsigned int parent = 0, child = 1;
+				while (child < k) {
+					if (child + 1 < k && nearest.entries[child + 1].distanceSquared > nearest.entries[child].distanceSquared) {
+						++child;
+					}
+					if (nearest.entries[child].distanceSquared <= distanceSquared) {
+						break;
+					}
+					nearest.entries[parent] = nearest.entries[child];
+					parent = child;
+					child = 2 * child + 1;
+				}
+				nearest.entries[parent] = { distanceSquared, &photon };
+				nearest.radiusSquared = nearest.entries[0].distanceSquared;
+			}
+		}
+
+		const unsigned int left = 2 * entry.node + 1;
+		if (left >= size) {
+			continue;
+		}
+		const unsigned int axis = splitAxes[entry.node];
+		const float planeDistance = position[axis] - photon.position[axis];
+		const unsigned int nearChild = planeDistance < 0 ? left : left + 1;
+		const unsigned int farChild = planeDistance < 0 ? left + 1 : left;
+
+		// Visit the near child first (it is pushed last).
+		if (farChild < size && planeDistance * planeDistance <= nearest.radiusSquared) {
+			stack[stackSize++] = { farChild, planeDistance * planeDistance };
+		}
+		if (nearChild < size) {
+			stack[stackSize++] = { nearChild, 0.0f };
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+#include <climits>
+
+#include <glm.hpp>
+
+#include "Photon.h"
+
+/// <summary>
+/// The result of a k-nearest-neighbour photon query. The photons are kept in a fixed-size max-heap on their distance,
+/// so a query never allocates and its cost is bounded by the number of photons asked for.
+/// </summary>
+struct NearestPhotons {
+	/// <summary> The largest number of photons a single query can gather. </summary>
+	static const unsigned int MAX_COUNT = 128;
+
+	struct Entry {
+		float distanceSquared;
+		const Photon * photon;
+	};
+
+	/// <summary> The found photons (in heap order, not sorted). Only the first count entries are valid. </summary>
+	Entry entries[MAX_COUNT];
+	unsigned int count = 0;
+
+	/// <summary>
+	/// The squared radius of the sphere around the query position which contains exactly the found photons.
+	/// This is the squared distance to the farthest found photon if k photons were found, and the squared maximum radius otherwise.
+	/// </summary>
+	float radiusSquared = 0.0f;
+};
+
+/// <summary>
+/// A left-balanced kd-tree over photons, stored implicitly as a heap in one contiguous array
+/// (see Jensen, "Realistic Image Synthesis Using Photon Mapping", 2001). The children of node i are the nodes 2i + 1 and 2i + 2,
+/// so no child pointers are needed. The splitting axis of every node is stored as a byte in a separate array.
+/// All queries are const and iterative, so any number of threads can query the tree at once.
+/// </summary>
+class PhotonKDTree {
+public:
+	PhotonKDTree() {}
+	PhotonKDTree(const PhotonKDTree &) = delete;
+	PhotonKDTree & operator=(const PhotonKDTree &) = delete;
+
+	/// <summary> Builds the tree over the given photons. The top levels are built in parallel. </summary>
+	void Build(const std::vector<Photon> & photons);
+
+	/// <summary>
+	/// Uses a tree which was built earlier and is stored elsewhere (e.g. in a memory-mapped file), without copying it.
+	/// The memory must stay valid for as long as the tree is used.
+	/// </summary>
+	void Attach(const Photon * nodes, const unsigned char * splitAxes, const unsigned int size);
+
+	/// <summary> Returns the number of photons in the tree. </summary>
+	unsigned int Size() const { return size; }
+
+	/// <summary> Returns the photons in heap order (e.g. to store the tree in a file). </summary>
+	const Photon * GetNodes() const { return nodes; }
+
+	/// <summary> Returns the splitting axis of every node. </summary>
+	const unsigned char * GetSplitAxes() const { return splitAxes; }
+
+	/// <summary> Adds all photons within the given radius around a position to the output vector. </summary>
+	void FindWithinRadius(const glm::vec3 & position, const float radius, std::vector<Photon> & photonsInRadius) const;
+
+	/// <summary>
+	/// Counts the photons within the given radius around a position, without copying them.
+	/// The search stops as soon as maxCount photons are found, so at most maxCount is returned.
+	/// </summary>
+	unsigned int CountWithinRadius(const glm::vec3 & position, const float radius, const unsigned int maxCount = UINT_MAX) const;
+
+	/// <summary>
+	/// Finds the photon closest to a position within the given radius.
+	/// Returns a pointer to the photon, or nullptr if there is no photon within the radius.
+	/// </summary>
+	const Photon * FindNearest(const glm::vec3 & position, const float radius) const;
+
+	/// <summary>
+	/// Finds the k photons closest to a position, ignoring photons farther away than the maximum radius.
+	/// At most NearestPhotons::MAX_COUNT photons can be gathered at once.
+	/// </summary>
+	void FindNearestK(const glm::vec3 & position, const unsigned int k, NearestPhotons & nearest, const float maxRadius = FLT_MAX) const;
+
+private:
+	/// <summary> The photons in heap order. </summary>
+	const Photon * nodes = nullptr;
+
+	/// <summary> The splitting axis (0, 1 or 2) of every node. </summary>
+	const unsigned char * splitAxes = nullptr;
+
+	unsigned int size = 0;
+
+	/// <summary> The storage of nodes and splitAxes if the tree was built (rather than attached). </summary>
+	std::vector<Photon> nodeStorage;
+	std::vector<unsigned char> splitAxisStorage;
+
+	/// <summary> The maximum depth of a tree with 2^32 photons, which bounds the traversal stacks. </summary>
+	static const unsigned int MAX_DEPTH = 32;
+
+	/// <summary>
+	/// Builds the subtree rooted at the given node over photons [first, last) of the working array.
+	/// Subtrees down to the given depth are built on new threads.
+	/// </summary>
+	void BuildSubtree(std::vector<Photon> & photons, const unsigned int first, const unsigned int last,
+					  const unsigned int node, const unsigned int parallelDepth);
+
+	/// <summary> Returns the size of the left subtree of a left-balanced tree with the given size. </summary>
+	static unsigned int LeftSubtreeSize(const unsigned int size);
+};
@@ -1,6 +1,14 @@
 #include "PhotonMap.h"
 
 #define __PRINT_RESULT true
+#define __USE_PARALLEL_PHOTON_EMISSION true // Trace the photon paths on all threads.
+#define __USE_PHOTON_MAP_CACHE true // Store built photon maps in files, and reuse them when the scene and the settings are unchanged.
+#define __PHOTON_MAP_CACHE_DIRECTORY "output/" // The directory of the photon map cache files.
+#define __PHOTON_MAP_CACHE_VERSION 2u // Must be increased when the photon tracing or the file layout changes.
+#define __IRRADIANCE_PHOTON_SPACING 4u // Irradiance is precomputed at every n:th global photon.
+#define __IRRADIANCE_GATHER_COUNT 64u // The number of direct and of indirect photons used to estimate irradiance.
+#define __IRRADIANCE_GATHER_RADIUS 0.5f // The largest distance at which photons are used to estimate irradiance.
+#define __IRRADIANCE_LOOKUP_COUNT 8u // The number of irradiance photons searched for one with a similar normal.
 
 #if __PRINT_RESULT
 #include <iostream>
@@ -8,24 +16,46 @@
 #include <random>
 #include <numeric>
 #include <algorithm>
-#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "../../includes/glm/gtx/norm.hpp"
 
 #include "../Utility/Math.h"
 #include "../Utility/Other.h"
+#include "../Utility/Random.h"
+#include "../Utility/ThreadPool.h"
+#include "../Utility/Hash.h"
 #include "../Scene/Scene.h"
-
-PhotonMap::PhotonMap(const Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_DEPTH) {
+#include "../Rendering/RenderingConstants.h"
+
+PhotonMap::PhotonMap(const Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_DEPTH,
+					 const bool PRECOMPUTE_IRRADIANCE, const unsigned int THREAD_COUNT) {
+
+#if __USE_PHOTON_MAP_CACHE
+	// Use the photon map of an earlier run if the scene and the settings are unchanged.
+	const uint64_t hash = ComputeHash(scene, PHOTONS_PER_LIGHT_SOURCE, MAX_DEPTH, PRECOMPUTE_IRRADIANCE);
+	std::ostringstream cachePathStream;
+	cachePathStream << __PHOTON_MAP_CACHE_DIRECTORY << "photonmap_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+	const std::string cachePath = cachePathStream.str();
+	if (LoadFromFile(cachePath, hash)) {
+		std::cout << "Loaded the photon map from " << cachePath << "." << std::endl;
+		return;
+	}
+#endif
 
 	// Initialize.
 	std::cout << "Building the photon map ..." << std::endl;
 
-	std::vector<Photon> directPhotons;
-	std::vector<Photon> indirectPhotons;
-	std::vector<Photon> shadowPhotons;
-	std::vector<Photon> causticsPhotons;
-
 	// Calculate max emissivity so that we can normalize photon radiance.
 	float maxEmissivity = 0;
 	for (const auto * lightSource : scene.emissiveRenderGroups) {
@@ -36,82 +66,6 @@ PhotonMap::PhotonMap(const Scene & scene, const unsigned int PHOTONS_PER_LIGHT_S
 	}
 	const float INV_MAX_EMISSIVITY = 1.0f / maxEmissivity;
 
-	// Shoot photons from all light sources.
-	for (const auto * lightSource : scene.emissiveRenderGroups) {
-		for (unsigned int j = 0; j < PHOTONS_PER_LIGHT_SOURCE; ++j) {
-			auto * lightPrimitive = lightSource->primitives[rand() % lightSource->primitives.size()];
-
-			// Create a random photon direction from a random light surface position.
-			glm::vec3 randomSurfacePosition = lightPrimitive->GetRandomPositionOnSurface();
-			glm::vec3 surfaceNormal = lightPrimitive->GetNormal(randomSurfacePosition);
-			glm::vec3 randomHemisphereDirection;
-			randomHemisphereDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(surfaceNormal);
-			Ray ray(randomSurfacePosition + 0.01f*surfaceNormal, randomHemisphereDirection);
-			glm::vec3 photonRadiance = glm::dot(ray.direction, surfaceNormal) * lightSource->material->GetEmissionColor();
-
-			// Iterative deepening.
-			for (unsigned int k = 0; k < MAX_DEPTH; ++k) {
-				float intersectionDistance;
-				unsigned int intersectionRenderGroupIndex, intersectionPrimitiveIndex;
-
-				// Shoot photon.
-				if (scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
-
-					// The photon hit something.
-					glm::vec3 intersectionPosition = ray.from + intersectionDistance * ray.direction;
-					const RenderGroup & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
-					Primitive * intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-					Material * intersectionMaterial = scene.renderGroups[intersectionRenderGroupIndex].material;
-					glm::vec3 intersectionNormal = intersectionPrimitive->GetNormal(intersectionPosition);
-					glm::vec3 rayReflection = Utility::Math::CosineWeightedHemisphereSampleDirection(intersectionNormal);
-
-					// Indirect photon if deeper than 0.
-					if (k > 0) {
-						Photon photon = Photon(intersectionPosition, ray.direction, photonRadiance, intersectionPrimitive);
-						indirectPhotons.push_back(photon);
-
-						// Calculate probability for reflection/absorption and use Russian roulette to decide whether to reflect or not.
-						float p = INV_MAX_EMISSIVITY * (photonRadiance.r + photonRadiance.b + photonRadiance.g);
-						float rand = std::rand() / (float)RAND_MAX;
-						if (rand > p) {
-							break;
-						}
-					}
-					// Otherwise direct and shadow photons.
-					else {
-						Photon photon = Photon(intersectionPosition, ray.direction, photonRadiance, intersectionPrimitive);
-						directPhotons.push_back(photon);
-
-						// Create a shadow ray.
-						Ray shadowRay(intersectionPosition + 0.01f * ray.direction, ray.direction);
-						Primitive * shadowPrimitive = intersectionPrimitive;
-
-						// While we hit a surface keep casting and add shadow photons.
-						float shadowIntersectionDistance;
-						unsigned int shadowIntersectionRenderGroupIdx, shadowIntersectionPrimitiveIdx;
-						while (scene.RayCast(shadowRay, shadowIntersectionRenderGroupIdx, shadowIntersectionPrimitiveIdx, shadowIntersectionDistance)) {
-							shadowPrimitive = scene.renderGroups[shadowIntersectionRenderGroupIdx].primitives[shadowIntersectionPrimitiveIdx];
-							glm::vec3 shadowIntersectionPosition = shadowRay.from + shadowIntersectionDistance * shadowRay.direction;
-							Photon photon = Photon(shadowIntersectionPosition, ray.direction, glm::vec3(0, 0, 0), shadowPrimitive);
-							shadowPhotons.push_back(photon);
-							// Update ray position. Direction is the same all the time.
-							shadowRay.from = shadowIntersectionPosition + 0.01f * ray.direction;
-						}
-					}
-					photonRadiance = intersectionMaterial->CalculateDiffuseLighting(ray.direction, rayReflection, intersectionNormal, photonRadiance);
-					ray.from = intersectionPosition + 0.001f*intersectionNormal;
-					ray.direction = rayReflection;
-				}
-				else {
-					break;
-				}
-			}
-		}
-	}
-
-	// -------------------------------
-	// Caustics photons.
-	// -------------------------------
 	std::vector<const RenderGroup*> transparentObjects;
 	for (const RenderGroup & rg : scene.renderGroups) {
 		Material* mat = rg.material;
@@ -119,134 +73,461 @@ PhotonMap::PhotonMap(const Scene & scene, const unsigned int PHOTONS_PER_LIGHT_S
 			transparentObjects.push_back(&rg);
 		}
 	}
-	if (transparentObjects.size() > 0) {
-		for (const auto * lightSource : scene.emissiveRenderGroups) {
-			for (unsigned int j = 0; j < PHOTONS_PER_LIGHT_SOURCE; ++j) {
-				auto * lightPrimitive = lightSource->primitives[rand() % lightSource->primitives.size()];
-
-				// Create a random photon direction from a random light surface position.
-				glm::vec3 randomSurfacePosition = lightPrimitive->GetRandomPositionOnSurface();
-				glm::vec3 surfaceNormal = lightPrimitive->GetNormal(randomSurfacePosition);
-				glm::vec3 randomHemisphereDirection;
-				glm::vec3 posOnSurface = transparentObjects[rand() % transparentObjects.size()]->GetRandomPositionOnSurface();
-				randomHemisphereDirection = glm::normalize(posOnSurface - randomSurfacePosition);
-				Ray ray(randomSurfacePosition + 0.01f*surfaceNormal, randomHemisphereDirection);
-				glm::vec3 photonRadiance = glm::dot(ray.direction, surfaceNormal) * lightSource->material->GetEmissionColor();
-
-				// Iterative deepening.
-				for (unsigned int k = 0; k < MAX_DEPTH; ++k) {
-					float intersectionDistance;
-					unsigned int intersectionRenderGroupIndex, intersectionPrimitiveIndex;
-
-					// Shoot photon.
-					if (scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
-
-						// The photon hit something.
-						glm::vec3 intersectionPosition = ray.from + intersectionDistance * ray.direction;
-						const RenderGroup & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
-						Primitive * intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-						Material * intersectionMaterial = scene.renderGroups[intersectionRenderGroupIndex].material;
-						glm::vec3 intersectionNormal = intersectionPrimitive->GetNormal(intersectionPosition);
-						glm::vec3 rayReflection = Utility::Math::CosineWeightedHemisphereSampleDirection(intersectionNormal);
-
-						if (intersectionMaterial->IsTransparent()) {
-							const float n1 = 1.0f;
-							const float n2 = intersectionMaterial->refractiveIndex;
-							glm::vec3 offset = intersectionNormal * 0.1f;
-							Ray refractedRay(intersectionPosition - offset, glm::refract(ray.direction, intersectionNormal, n1 / n2));
-
-							// Find out if the ray "exits" the render group anywhere.
-							if (scene.RenderGroupRayCast(refractedRay, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
-								const auto & refractedRayHitPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-								const glm::vec3 refractedIntersectionPoint = refractedRay.from + refractedRay.direction * intersectionDistance;
-								const glm::vec3 refractedHitNormal = refractedRayHitPrimitive->GetNormal(refractedIntersectionPoint);
-
-								photonRadiance = intersectionMaterial->CalculateDiffuseLighting(ray.direction, rayReflection, intersectionNormal, photonRadiance);
-								ray.from = refractedIntersectionPoint + refractedRay.direction * 0.001f;
-								ray.direction = glm::refract(refractedRay.direction, -refractedHitNormal, n2 / n1);
-							}
-						}
-						// We hit a none refractive surface, store caustics photon if we are not on depth 0.
-						else if (k > 0) {
-							Photon photon = Photon(intersectionPosition, ray.direction, photonRadiance, intersectionPrimitive);
-							causticsPhotons.push_back(photon);
-							break;
-						}
-						else {
-							break;
-						}
-					}
-					else {
-						break;
-					}
-				}
-			}
+
+	// Split the photon paths of every light source into batches, first for the global photons and then for the caustics photons.
+	// Every photon path has its own random sequence, so the batches can be traced in any order and on any thread.
+	const unsigned int BATCHES_PER_LIGHT_SOURCE = (PHOTONS_PER_LIGHT_SOURCE + __PHOTON_BATCH_SIZE - 1) / __PHOTON_BATCH_SIZE;
+	const unsigned int GLOBAL_BATCH_COUNT = static_cast<unsigned int>(scene.emissiveRenderGroups.size()) * BATCHES_PER_LIGHT_SOURCE;
+	const unsigned int BATCH_COUNT = GLOBAL_BATCH_COUNT * (transparentObjects.size() > 0 ? 2 : 1);
+	std::vector<PhotonBatch> batches(BATCH_COUNT);
+	Utility::ThreadPool threadPool(__USE_PARALLEL_PHOTON_EMISSION ? THREAD_COUNT : 1);
+	threadPool.Run(BATCH_COUNT, [&](unsigned int batchIndex, unsigned int) {
+		const unsigned int i = (batchIndex % GLOBAL_BATCH_COUNT) / BATCHES_PER_LIGHT_SOURCE;
+		const unsigned int first = (batchIndex % BATCHES_PER_LIGHT_SOURCE) * __PHOTON_BATCH_SIZE;
+		const unsigned int last = std::min(first + __PHOTON_BATCH_SIZE, PHOTONS_PER_LIGHT_SOURCE);
+		if (batchIndex < GLOBAL_BATCH_COUNT) {
+			TraceGlobalPhotons(scene, i, first, last, MAX_DEPTH, INV_MAX_EMISSIVITY, batches[batchIndex]);
 		}
-	}
+		else {
+			TraceCausticsPhotons(scene, transparentObjects, i, first, last, MAX_DEPTH, batches[batchIndex]);
+		}
+	});
+
+	// Merge the batches in order, which gives the same photons (in the same order) for any number of threads.
+	std::vector<Photon> directPhotons;
+	std::vector<Photon> indirectPhotons;
+	std::vector<Photon> shadowPhotons;
+	std::vector<Photon> causticsPhotons;
+	MergeBatches(batches, &PhotonBatch::directPhotons, directPhotons);
+	MergeBatches(batches, &PhotonBatch::indirectPhotons, indirectPhotons);
+	MergeBatches(batches, &PhotonBatch::shadowPhotons, shadowPhotons);
+	MergeBatches(batches, &PhotonBatch::causticsPhotons, causticsPhotons);
+	batches.clear();
 
 	// Fix strength of photons based on total photons
 	for (Photon & photon : directPhotons) {
-		photon.color /= (float)directPhotons.size() + (float)indirectPhotons.size();
-		directPhotonsKDTree.insert(KDTreeNode(photon)); // This copy of the photons is inefective but the kd tree crashes when using photon pointers atm
+		photon.SetColor(photon.GetColor() / ((float)directPhotons.size() + (float)indirectPhotons.size()));
 	}
 	for (Photon & photon : indirectPhotons) {
-		photon.color /= (float)directPhotons.size() + (float)indirectPhotons.size();
-		indirectPhotonsKDTree.insert(KDTreeNode(photon));
-	}
-	for (Photon & photon : shadowPhotons) {
-		shadowPhotonsKDTree.insert(KDTreeNode(photon));
+		photon.SetColor(photon.GetColor() / ((float)directPhotons.size() + (float)indirectPhotons.size()));
 	}
 	float amountOfCausticsPhotonsPerTransparentObject = causticsPhotons.size() / (float)transparentObjects.size();
 	for (Photon & photon : causticsPhotons) {
-		photon.color /= amountOfCausticsPhotonsPerTransparentObject;
-		causticsPhotonsKDTree.insert(KDTreeNode(photon));
+		photon.SetColor(photon.GetColor() / amountOfCausticsPhotonsPerTransparentObject);
 	}
 
-	// Finalize by balancing and optimizing the k-d trees.
-	directPhotonsKDTree.optimize();
-	indirectPhotonsKDTree.optimize();
-	shadowPhotonsKDTree.optimize();
+	// Finalize by building the (balanced) k-d trees.
+	directPhotonsKDTree.Build(directPhotons);
+	indirectPhotonsKDTree.Build(indirectPhotons);
+	shadowPhotonsKDTree.Build(shadowPhotons);
+	causticsPhotonsKDTree.Build(causticsPhotons);
+
+	// Precompute the irradiance at a subset of the global photons (Christensen, "Faster Photon Map Global Illumination", 1999).
+	std::vector<Photon> irradiancePhotons;
+	if (PRECOMPUTE_IRRADIANCE) {
+		for (const std::vector<Photon> * photons : { &directPhotons, &indirectPhotons }) {
+			for (size_t i = 0; i < photons->size(); i += __IRRADIANCE_PHOTON_SPACING) {
+				irradiancePhotons.push_back((*photons)[i]);
+			}
+		}
+	}
+	const unsigned int IRRADIANCE_TASK_COUNT = static_cast<unsigned int>((irradiancePhotons.size() + __PHOTON_BATCH_SIZE - 1) / __PHOTON_BATCH_SIZE);
+	threadPool.Run(IRRADIANCE_TASK_COUNT, [&](unsigned int task, unsigned int) {
+		const size_t last = std::min<size_t>((task + 1) * static_cast<size_t>(__PHOTON_BATCH_SIZE), irradiancePhotons.size());
+		for (size_t i = task * static_cast<size_t>(__PHOTON_BATCH_SIZE); i < last; ++i) {
+			Photon & photon = irradiancePhotons[i];
+			const glm::vec3 normal = photon.GetNormal();
+			photon = Photon(photon.position, -normal, EstimateIrradiance(photon.position, normal), normal);
+		}
+	});
+	irradiancePhotonsKDTree.Build(irradiancePhotons);
 
 #if __PRINT_RESULT
 	// Print results.
 	std::cout << "Photon map was built successfully." << std::endl;
-	std::cout << "Total direct photons: " << directPhotonsKDTree.size() << std::endl;
-	std::cout << "Total indirect photons: " << indirectPhotonsKDTree.size() << std::endl;
-	std::cout << "Total shadow photons: " << shadowPhotonsKDTree.size() << std::endl;
-	std::cout << "Total caustics photons: " << causticsPhotonsKDTree.size() << std::endl;
+	std::cout << "Total direct photons: " << directPhotonsKDTree.Size() << std::endl;
+	std::cout << "Total indirect photons: " << indirectPhotonsKDTree.Size() << std::endl;
+	std::cout << "Total shadow photons: " << shadowPhotonsKDTree.Size() << std::endl;
+	std::cout << "Total caustics photons: " << causticsPhotonsKDTree.Size() << std::endl;
+	std::cout << "Total irradiance photons: " << irradiancePhotonsKDTree.Size() << std::endl;
+#endif
+
+#if __USE_PHOTON_MAP_CACHE
+	if (!SaveToFile(cachePath, hash)) {
+		std::cout << "Could not write the photon map to " << cachePath << "." << std::endl;
+	}
 #endif
 }
 
+/// <summary>
+/// The header of a photon map cache file. It is followed by the photons of the direct, indirect, shadow, caustics and
+/// irradiance trees (in heap order), and then by the splitting axes of the five trees.
+/// </summary>
+struct PhotonMapFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t hash;
+	uint32_t photonSize;
+	uint32_t photonCounts[5];
+};
+
+glm::vec3 PhotonMap::EstimateIrradiance(const glm::vec3 & pos, const glm::vec3 & normal) const {
+	// The direct and the indirect photons are separate density estimates, each over its own nearest photons.
+	return EstimateIrradiance(directPhotonsKDTree, pos, normal) + EstimateIrradiance(indirectPhotonsKDTree, pos, normal);
+}
+
+glm::vec3 PhotonMap::EstimateDirectIrradiance(const glm::vec3 & pos, const glm::vec3 & normal) const {
+	return EstimateIrradiance(directPhotonsKDTree, pos, normal);
+}
 
-void PhotonMap::GetDirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius) {
+glm::vec3 PhotonMap::EstimateIrradiance(const PhotonKDTree & tree, const glm::vec3 & pos, const glm::vec3 & normal) {
+	NearestPhotons nearest;
+	tree.FindNearestK(pos, __IRRADIANCE_GATHER_COUNT, nearest, __IRRADIANCE_GATHER_RADIUS);
+	if (nearest.count == 0) {
+		return glm::vec3(0);
+	}
+	const float radiusSquared = std::max(nearest.radiusSquared, __MIN_DENSITY_ESTIMATE_RADIUS * __MIN_DENSITY_ESTIMATE_RADIUS);
+	glm::vec3 flux(0);
+	for (unsigned int i = 0; i < nearest.count; ++i) {
+		const Photon & photon = *nearest.entries[i].photon;
+		if (glm::dot(photon.GetNormal(), normal) >= __MIN_NORMAL_SIMILARITY && glm::dot(photon.GetDirection(), normal) < 0.0f) {
+			flux += photon.GetColor();
+		}
+	}
+	return flux / (glm::pi<float>() * radiusSquared);
+}
+
+const Photon * PhotonMap::GetIrradiancePhotons(unsigned int & count) const {
+	count = irradiancePhotonsKDTree.Size();
+	return irradiancePhotonsKDTree.GetNodes();
+}
+
+uint64_t PhotonMap::ComputeHash(const Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_DEPTH, const bool PRECOMPUTE_IRRADIANCE) {
+	Utility::Hash hash;
+	hash.Add(__PHOTON_MAP_CACHE_VERSION);
+	hash.Add(PHOTONS_PER_LIGHT_SOURCE);
+	hash.Add(MAX_DEPTH);
+	hash.Add(PRECOMPUTE_IRRADIANCE);
+	hash.Add(__IRRADIANCE_PHOTON_SPACING);
+	hash.Add(__IRRADIANCE_GATHER_COUNT);
+	hash.Add(__IRRADIANCE_GATHER_RADIUS);
+	hash.Add(__MIN_NORMAL_SIMILARITY); // Selects the photons of the irradiance estimates.
+	hash.Add(scene.renderGroups.size());
+	for (const RenderGroup & renderGroup : scene.renderGroups) {
+		hash.Add(renderGroup.enabled);
+		renderGroup.material->AddToHash(hash);
+		hash.Add(renderGroup.primitives.size());
+		for (const Primitive * primitive : renderGroup.primitives) {
+			hash.Add(primitive->enabled);
+			primitive->AddToHash(hash);
+		}
+	}
+	return hash.Get();
+}
+
+bool PhotonMap::LoadFromFile(const std::string & path, const uint64_t hash) {
+	if (!cacheFile.Open(path)) {
+		return false;
+	}
+
+	// Check that the file belongs to this scene and these settings, and that it is complete.
+	PhotonMapFileHeader header;
+	size_t expectedSize = sizeof(header);
+	if (cacheFile.GetSize() >= sizeof(header)) {
+		std::memcpy(&header, cacheFile.GetData(), sizeof(header));
+		for (const uint32_t photonCount : header.photonCounts) {
+			expectedSize += photonCount * (sizeof(Photon) + 1);
+		}
+	}
+	if (cacheFile.GetSize() < sizeof(header) || std::memcmp(header.magic, "PMAP", 4) != 0 || header.version != __PHOTON_MAP_CACHE_VERSION ||
+		header.hash != hash || header.photonSize != sizeof(Photon) || cacheFile.GetSize() != expectedSize) {
+		cacheFile.Close();
+		return false;
+	}
+
+	// Use the trees directly from the mapped file.
+	PhotonKDTree * trees[5] = { &directPhotonsKDTree, &indirectPhotonsKDTree, &shadowPhotonsKDTree, &causticsPhotonsKDTree, &irradiancePhotonsKDTree };
+	size_t photonCount = 0;
+	for (const uint32_t count : header.photonCounts) {
+		photonCount += count;
+	}
+	const Photon * photons = reinterpret_cast<const Photon *>(cacheFile.GetData() + sizeof(header));
+	const unsigned char * splitAxes = cacheFile.GetData() + sizeof(header) + photonCount * sizeof(Photon);
+	for (unsigned int i = 0; i < 5; ++i) {
+		trees[i]->Attach(photons, splitAxes, header.photonCounts[i]);
+		photons += header.photonCounts[i];
+		splitAxes += header.photonCounts[i];
+	}
+	return true;
+}
+
+bool PhotonMap::SaveToFile(const std::string & path, const uint64_t hash) const {
+	const PhotonKDTree * trees[5] = { &directPhotonsKDTree, &indirectPhotonsKDTree, &shadowPhotonsKDTree, &causticsPhotonsKDTree, &irradiancePhotonsKDTree };
+	PhotonMapFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "PMAP", 4);
+	header.version = __PHOTON_MAP_CACHE_VERSION;
+	header.hash = hash;
+	header.photonSize = sizeof(Photon);
+	for (unsigned int i = 0; i < 5; ++i) {
+		header.photonCounts[i] = trees[i]->Size();
+	}
+
+	// Write to a temporary file first, so that other runs never see a partially written file.
+	// The file is named by the process, so that runs which build the same photon map at once do not share it.
+	std::ostringstream temporaryPathStream;
+#ifdef _WIN32
+	temporaryPathStream << path << "." << _getpid() << ".tmp";
+#else
+	temporaryPathStream << path << "." << getpid() << ".tmp";
+#endif
+	const std::string temporaryPath = temporaryPathStream.str();
+	{
+		std::ofstream file(temporaryPath, std::ios::out | std::ios::binary);
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		for (const PhotonKDTree * tree : trees) {
+			file.write(reinterpret_cast<const char *>(tree->GetNodes()), tree->Size() * sizeof(Photon));
+		}
+		for (const PhotonKDTree * tree : trees) {
+			file.write(reinterpret_cast<const char *>(tree->GetSplitAxes()), tree->Size());
+		}
+		if (!file) {
+			file.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	// Replace any stale file with the same name (rename does not overwrite existing files on Windows).
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		std::remove(path.c_str());
+		if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+void PhotonMap::TraceGlobalPhotons(const Scene & scene, const unsigned int i, const unsigned int first, const unsigned int last,
+								   const unsigned int MAX_DEPTH, const float INV_MAX_EMISSIVITY, PhotonBatch & batch) {
+	const auto * lightSource = scene.emissiveRenderGroups[i];
+	std::vector<Intersection> shadowIntersections;
+	for (unsigned int j = first; j < last; ++j) {
+		// Every photon path has its own random sequence, given by its light source and photon index.
+		Utility::RandomGenerator random(j, 2 * i);
+		auto * lightPrimitive = lightSource->primitives[random.NextUInt(static_cast<uint32_t>(lightSource->primitives.size()))];
+
+		// Create a random photon direction from a random light surface position.
+		glm::vec3 randomSurfacePosition = lightPrimitive->GetRandomPositionOnSurface(random);
+		glm::vec3 surfaceNormal = lightPrimitive->GetNormal(randomSurfacePosition);
+		glm::vec3 randomHemisphereDirection;
+		randomHemisphereDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(surfaceNormal, random);
+		Ray ray(randomSurfacePosition + 0.01f*surfaceNormal, randomHemisphereDirection);
+		glm::vec3 photonRadiance = glm::dot(ray.direction, surfaceNormal) * lightSource->material->GetEmissionColor();
+
+		// Iterative deepening.
+		for (unsigned int k = 0; k < MAX_DEPTH; ++k) {
+			float intersectionDistance;
+			unsigned int intersectionRenderGroupIndex, intersectionPrimitiveIndex;
+
+			// Shoot photon.
+			if (scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+
+				// The photon hit something.
+				glm::vec3 intersectionPosition = ray.from + intersectionDistance * ray.direction;
+				const RenderGroup & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+				Primitive * intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+				Material * intersectionMaterial = scene.renderGroups[intersectionRenderGroupIndex].material;
+				glm::vec3 intersectionNormal = intersectionPrimitive->GetNormal(intersectionPosition);
+				glm::vec3 rayReflection = Utility::Math::CosineWeightedHemisphereSampleDirection(intersectionNormal, random);
+
+				// Indirect photon if deeper than 0.
+				if (k > 0) {
+					Photon photon = Photon(intersectionPosition, ray.direction, photonRadiance, intersectionNormal);
+					batch.indirectPhotons.push_back(photon);
+
+					// Calculate probability for reflection/absorption and use Russian roulette to decide whether to reflect or not.
+					float p = INV_MAX_EMISSIVITY * (photonRadiance.r + photonRadiance.b + photonRadiance.g);
+					if (random.NextFloat() > p) {
+						break;
+					}
+				}
+				// Otherwise direct and shadow photons.
+				else {
+					Photon photon = Photon(intersectionPosition, ray.direction, photonRadiance, intersectionNormal);
+					batch.directPhotons.push_back(photon);
+
+					// Add a shadow photon at every surface behind the direct photon (found in a single traversal).
+					Ray shadowRay = ray;
+					shadowRay.tMin = intersectionDistance;
+					scene.RayCastAll(shadowRay, shadowIntersections);
+					for (const auto & shadowIntersection : shadowIntersections) {
+						Primitive * shadowPrimitive = scene.renderGroups[shadowIntersection.renderGroupIndex].primitives[shadowIntersection.primitiveIndex];
+						glm::vec3 shadowIntersectionPosition = ray.from + shadowIntersection.distance * ray.direction;
+						Photon photon = Photon(shadowIntersectionPosition, ray.direction, glm::vec3(0, 0, 0), shadowPrimitive->GetNormal(shadowIntersectionPosition));
+						batch.shadowPhotons.push_back(photon);
+					}
+				}
+				photonRadiance = intersectionMaterial->CalculateDiffuseLighting(ray.direction, rayReflection, intersectionNormal, photonRadiance);
+				ray.from = intersectionPosition + 0.001f*intersectionNormal;
+				ray.direction = rayReflection;
+				ray.Update();
+			}
+			else {
+				break;
+			}
+		}
+	}
+}
+
+void PhotonMap::TraceCausticsPhotons(const Scene & scene, const std::vector<const RenderGroup*> & transparentObjects, const unsigned int i,
+									 const unsigned int first, const unsigned int last, const unsigned int MAX_DEPTH, PhotonBatch & batch) {
+	const auto * lightSource = scene.emissiveRenderGroups[i];
+	for (unsigned int j = first; j < last; ++j) {
+		Utility::RandomGenerator random(j, 2 * i + 1);
+		auto * lightPrimitive = lightSource->primitives[random.NextUInt(static_cast<uint32_t>(lightSource->primitives.size()))];
+
+		// Create a random photon direction from a random light surface position.
+		glm::vec3 randomSurfacePosition = lightPrimitive->GetRandomPositionOnSurface(random);
+		glm::vec3 surfaceNormal = lightPrimitive->GetNormal(randomSurfacePosition);
+		glm::vec3 randomHemisphereDirection;
+		glm::vec3 posOnSurface = transparentObjects[random.NextUInt(static_cast<uint32_t>(transparentObjects.size()))]->GetRandomPositionOnSurface(random);
+		randomHemisphereDirection = glm::normalize(posOnSurface - randomSurfacePosition);
+		Ray ray(randomSurfacePosition + 0.01f*surfaceNormal, randomHemisphereDirection);
+		glm::vec3 photonRadiance = glm::dot(ray.direction, surfaceNormal) * lightSource->material->GetEmissionColor();
+
+		// Iterative deepening.
+		for (unsigned int k = 0; k < MAX_DEPTH; ++k) {
+			float intersectionDistance;
+			unsigned int intersectionRenderGroupIndex, intersectionPrimitiveIndex;
+
+			// Shoot photon.
+			if (scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+
+				// The photon hit something.
+				glm::vec3 intersectionPosition = ray.from + intersectionDistance * ray.direction;
+				const RenderGroup & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+				Primitive * intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+				Material * intersectionMaterial = scene.renderGroups[intersectionRenderGroupIndex].material;
+				glm::vec3 intersectionNormal = intersectionPrimitive->GetNormal(intersectionPosition);
+				glm::vec3 rayReflection = Utility::Math::CosineWeightedHemisphereSampleDirection(intersectionNormal, random);
+
+				if (intersectionMaterial->IsTransparent()) {
+					const float n1 = 1.0f;
+					const float n2 = intersectionMaterial->refractiveIndex;
+					glm::vec3 offset = intersectionNormal * 0.1f;
+					Ray refractedRay(intersectionPosition - offset, glm::refract(ray.direction, intersectionNormal, n1 / n2));
+
+					// Find out if the ray "exits" the render group anywhere.
+					if (scene.RenderGroupRayCast(refractedRay, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+						const auto & refractedRayHitPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+						const glm::vec3 refractedIntersectionPoint = refractedRay.from + refractedRay.direction * intersectionDistance;
+						const glm::vec3 refractedHitNormal = refractedRayHitPrimitive->GetNormal(refractedIntersectionPoint);
+
+						photonRadiance = intersectionMaterial->CalculateDiffuseLighting(ray.direction, rayReflection, intersectionNormal, photonRadiance);
+						ray.from = refractedIntersectionPoint + refractedRay.direction * 0.001f;
+						ray.direction = glm::refract(refractedRay.direction, -refractedHitNormal, n2 / n1);
+						ray.Update();
+					}
+				}
+				// We hit a none refractive surface, store caustics photon if we are not on depth 0.
+				else if (k > 0) {
+					Photon photon = Photon(intersectionPosition, ray.direction, photonRadiance, intersectionNormal);
+					batch.causticsPhotons.push_back(photon);
+					break;
+				}
+				else {
+					break;
+				}
+			}
+			else {
+				break;
+			}
+		}
+	}
+}
+
+void PhotonMap::MergeBatches(const std::vector<PhotonBatch> & batches, std::vector<Photon> PhotonBatch::* photonsOfBatch, std::vector<Photon> & photons) {
+	size_t count = 0;
+	for (const PhotonBatch & batch : batches) {
+		count += (batch.*photonsOfBatch).size();
+	}
+	photons.reserve(count);
+	for (const PhotonBatch & batch : batches) {
+		photons.insert(photons.end(), (batch.*photonsOfBatch).begin(), (batch.*photonsOfBatch).end());
+	}
+}
+
+void PhotonMap::GetDirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const {
 	photonsInRadius.clear();
-	directPhotonsReferenceNode.photon.position = pos;
-	directPhotonsKDTree.find_within_range(directPhotonsReferenceNode, radius, std::back_insert_iterator<std::vector<KDTreeNode>>(photonsInRadius));
+	directPhotonsKDTree.FindWithinRadius(pos, radius, photonsInRadius);
 }
 
-void PhotonMap::GetIndirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius) {
+void PhotonMap::GetIndirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const {
 	photonsInRadius.clear();
-	indirectPhotonsReferenceNode.photon.position = pos;
-	indirectPhotonsKDTree.find_within_range(indirectPhotonsReferenceNode, radius, std::back_insert_iterator<std::vector<KDTreeNode>>(photonsInRadius));
+	indirectPhotonsKDTree.FindWithinRadius(pos, radius, photonsInRadius);
 }
 
-void PhotonMap::GetShadowPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius) {
+void PhotonMap::GetShadowPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const {
 	photonsInRadius.clear();
-	shadowPhotonsReferenceNode.photon.position = pos;
-	shadowPhotonsKDTree.find_within_range(shadowPhotonsReferenceNode, radius, std::back_insert_iterator<std::vector<KDTreeNode>>(photonsInRadius));
+	shadowPhotonsKDTree.FindWithinRadius(pos, radius, photonsInRadius);
 }
 
-void PhotonMap::GetCausticsPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius) {
+void PhotonMap::GetCausticsPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const {
 	photonsInRadius.clear();
-	causticsPhotonsReferenceNode.photon.position = pos;
-	causticsPhotonsKDTree.find_within_range(causticsPhotonsReferenceNode, radius, std::back_insert_iterator<std::vector<KDTreeNode>>(photonsInRadius));
+	causticsPhotonsKDTree.FindWithinRadius(pos, radius, photonsInRadius);
+}
+
+unsigned int PhotonMap::CountDirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, const unsigned int maxCount) const {
+	return directPhotonsKDTree.CountWithinRadius(pos, radius, maxCount);
+}
+
+unsigned int PhotonMap::CountShadowPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, const unsigned int maxCount) const {
+	return shadowPhotonsKDTree.CountWithinRadius(pos, radius, maxCount);
+}
+
+void PhotonMap::GetNearestDirectPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius) const {
+	directPhotonsKDTree.FindNearestK(pos, k, nearest, maxRadius);
+}
+
+void PhotonMap::GetNearestIndirectPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius) const {
+	indirectPhotonsKDTree.FindNearestK(pos, k, nearest, maxRadius);
+}
+
+void PhotonMap::GetNearestShadowPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius) const {
+	shadowPhotonsKDTree.FindNearestK(pos, k, nearest, maxRadius);
+}
+
+void PhotonMap::GetNearestCausticsPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius) const {
+	causticsPhotonsKDTree.FindNearestK(pos, k, nearest, maxRadius);
+}
+
+bool PhotonMap::GetIrradianceAtPosition(const glm::vec3 & pos, const glm::vec3 & normal, const float maxRadius, glm::vec3 & irradiance) const {
+	NearestPhotons nearest;
+	irradiancePhotonsKDTree.FindNearestK(pos, __IRRADIANCE_LOOKUP_COUNT, nearest, maxRadius);
+	const Photon * closest = nullptr;
+	float closestDistanceSquared = FLT_MAX;
+	for (unsigned int i = 0; i < nearest.count; ++i) {
+		const Photon & photon = *nearest.entries[i].photon;
+		if (nearest.entries[i].distanceSquared < closestDistanceSquared && glm::dot(photon.GetNormal(), normal) >= __MIN_NORMAL_SIMILARITY) {
+			closest = &photon;
+			closestDistanceSquared = nearest.entries[i].distanceSquared;
+		}
+	}
+	if (closest == nullptr) {
+		return false;
+	}
+	irradiance = closest->GetColor();
+	return true;
 }
 
-bool PhotonMap::GetClosestDirectPhotonAtPositionWithinRadius(const glm::vec3 & pos, const float radius, Photon & photon) {
-	directPhotonsReferenceNode.photon.position = pos;
-	auto result = directPhotonsKDTree.find_nearest(directPhotonsReferenceNode, radius);
-	if (result.first != directPhotonsKDTree.end()) {
-		photon = (*result.first).photon;
+bool PhotonMap::GetClosestDirectPhotonAtPositionWithinRadius(const glm::vec3 & pos, const float radius, Photon & photon) const {
+	const Photon * nearest = directPhotonsKDTree.FindNearest(pos, radius);
+	if (nearest != nullptr) {
+		photon = *nearest;
 		return true;
 	}
 	return false;
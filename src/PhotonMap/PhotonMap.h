@@ -1,8 +1,12 @@
 #pragma once
 
-#include <kdtree.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
 
 #include "Photon.h"
+#include "PhotonKDTree.h"
+#include "../Utility/MappedFile.h"
 
 class PhotonMap
 {
@@ -10,82 +14,184 @@ public:
 
 	/// <summary> 
 	/// Constructs a photon map by shooting photons into the scene.
-	/// The photons are then stored in a kd-tree.
+	/// The photon paths are traced in parallel batches, which are merged in a fixed order.
+	/// The photons are then stored in a kd-tree. Finally, the irradiance is precomputed at every few global photons (if requested).
+	/// Built photon maps are cached in files named by a hash of the scene and the settings. If a cache file exists,
+	/// it is memory-mapped and used directly instead of shooting any photons.
+	/// The photon map is not modified by queries, so any number of threads can query it at once.
 	/// </summary>
 	/// <param name='scene'> The scene which we inject photons into. </param>
 	/// <param name='PHOTONS_PER_LIGHT_SOURCE'> The amount of photons used per light source. </param>
 	/// <param name='MAX_DEPTH'> The number of bounces each photon will make (at most). </param>
-	PhotonMap(const class Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_DEPTH);
-
-	/// <summary> 
-	/// A photon (node) wrapper for use with kdtree++.
-	/// </summary>
-	class KDTreeNode {
-	public:
-		using value_type = float;
-		Photon photon;
-		KDTreeNode() {}
-		KDTreeNode(const Photon & _photon) : photon(_photon) {}
-		value_type operator[](unsigned int n) const { return photon.position[n]; }
-		float distance(const KDTreeNode & other) { return glm::distance(other.photon.position, photon.position); }
-	};
+	/// <param name='PRECOMPUTE_IRRADIANCE'> Whether to precompute the irradiance photons (see GetIrradianceAtPosition). </param>
+	/// <param name='THREAD_COUNT'> The number of threads used to shoot photons. Uses all hardware threads if 0. </param>
+	PhotonMap(const class Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_DEPTH,
+			  const bool PRECOMPUTE_IRRADIANCE = false, const unsigned int THREAD_COUNT = 0);
 
 	/// <summary> 
 	/// Returns direct photons located within a given radius around a given world position.
 	/// The photons are added to the vector photonsInRadius.
 	/// </summary>
-	/// <param name='node'> The node to search around. </param>
+	/// <param name='pos'> The position to search around. </param>
 	/// <param name='radius'> The radius to search with. </param>
 	/// <param name='photonsInRadius'> Found photons are added to this vector. </param>
-	void GetDirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius);
+	void GetDirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const;
 
 	/// <summary> 
 	/// Returns indirect photons located within a given radius around a given world position.
 	/// The photons are added to the vector photonsInRadius.
 	/// </summary>
-	/// <param name='node'> The node to search around. </param>
+	/// <param name='pos'> The position to search around. </param>
 	/// <param name='radius'> The radius to search with. </param>
 	/// <param name='photonsInRadius'> Found photons are added to this vector. </param>
-	void GetIndirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius);
+	void GetIndirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const;
 
 	/// <summary> 
 	/// Returns shadow photons located within a given radius around a given world position.
 	/// The photons are added to the vector photonsInRadius.
 	/// </summary>
-	/// <param name='node'> The node to search around. </param>
+	/// <param name='pos'> The position to search around. </param>
 	/// <param name='radius'> The radius to search with. </param>
 	/// <param name='photonsInRadius'> Found photons are added to this vector. </param>
-	void GetShadowPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius);
+	void GetShadowPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const;
 
 	/// <summary> 
 	/// Returns caustics photons located within a given radius around a given world position.
 	/// The photons are added to the vector photonsInRadius.
 	/// </summary>
-	/// <param name='node'> The node to search around. </param>
+	/// <param name='pos'> The position to search around. </param>
 	/// <param name='radius'> The radius to search with. </param>
 	/// <param name='photonsInRadius'> Found photons are added to this vector. </param>
-	void GetCausticsPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<KDTreeNode> & photonsInRadius);
+	void GetCausticsPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, std::vector<Photon> & photonsInRadius) const;
+
+	/// <summary> 
+	/// Counts the direct photons located within a given radius around a given world position, without copying them.
+	/// Counting stops once maxCount photons are found, so at most maxCount is returned.
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='radius'> The radius to search with. </param>
+	/// <param name='maxCount'> The number of photons after which counting stops. </param>
+	unsigned int CountDirectPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, const unsigned int maxCount = UINT_MAX) const;
+
+	/// <summary> 
+	/// Counts the shadow photons located within a given radius around a given world position, without copying them.
+	/// Counting stops once maxCount photons are found, so at most maxCount is returned.
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='radius'> The radius to search with. </param>
+	/// <param name='maxCount'> The number of photons after which counting stops. </param>
+	unsigned int CountShadowPhotonsAtPositionWithinRadius(const glm::vec3 & pos, const float radius, const unsigned int maxCount = UINT_MAX) const;
+
+	/// <summary> 
+	/// Finds the k direct photons closest to a given world position, ignoring photons farther away than maxRadius.
+	/// The radius of the sphere which holds the found photons is returned in nearest.radiusSquared (for density estimation).
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='k'> The number of photons to gather (at most NearestPhotons::MAX_COUNT). </param>
+	/// <param name='nearest'> The found photons. </param>
+	/// <param name='maxRadius'> The largest distance at which photons are gathered. </param>
+	void GetNearestDirectPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius = FLT_MAX) const;
+
+	/// <summary> 
+	/// Finds the k indirect photons closest to a given world position, ignoring photons farther away than maxRadius.
+	/// The radius of the sphere which holds the found photons is returned in nearest.radiusSquared (for density estimation).
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='k'> The number of photons to gather (at most NearestPhotons::MAX_COUNT). </param>
+	/// <param name='nearest'> The found photons. </param>
+	/// <param name='maxRadius'> The largest distance at which photons are gathered. </param>
+	void GetNearestIndirectPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius = FLT_MAX) const;
+
+	/// <summary> 
+	/// Finds the k shadow photons closest to a given world position, ignoring photons farther away than maxRadius.
+	/// The radius of the sphere which holds the found photons is returned in nearest.radiusSquared (for density estimation).
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='k'> The number of photons to gather (at most NearestPhotons::MAX_COUNT). </param>
+	/// <param name='nearest'> The found photons. </param>
+	/// <param name='maxRadius'> The largest distance at which photons are gathered. </param>
+	void GetNearestShadowPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius = FLT_MAX) const;
+
+	/// <summary> 
+	/// Finds the k caustics photons closest to a given world position, ignoring photons farther away than maxRadius.
+	/// The radius of the sphere which holds the found photons is returned in nearest.radiusSquared (for density estimation).
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='k'> The number of photons to gather (at most NearestPhotons::MAX_COUNT). </param>
+	/// <param name='nearest'> The found photons. </param>
+	/// <param name='maxRadius'> The largest distance at which photons are gathered. </param>
+	void GetNearestCausticsPhotonsAtPosition(const glm::vec3 & pos, const unsigned int k, NearestPhotons & nearest, const float maxRadius = FLT_MAX) const;
+
+	/// <summary> 
+	/// Finds the precomputed irradiance of the closest irradiance photon within maxRadius of a given world position,
+	/// which lies on a surface with (almost) the given normal. If no such photon is found then false is returned, else true.
+	/// </summary>
+	/// <param name='pos'> The position to search around. </param>
+	/// <param name='normal'> The surface normal at the position. </param>
+	/// <param name='maxRadius'> The largest distance at which irradiance photons are used. </param>
+	/// <param name='irradiance'> The found irradiance. </param>
+	bool GetIrradianceAtPosition(const glm::vec3 & pos, const glm::vec3 & normal, const float maxRadius, glm::vec3 & irradiance) const;
+
+	/// <summary> Estimates the irradiance at a surface point from the nearest direct photons only. </summary>
+	glm::vec3 EstimateDirectIrradiance(const glm::vec3 & pos, const glm::vec3 & normal) const;
+
+	/// <summary> Returns the photons which hold the precomputed irradiance (as their color), and their number. </summary>
+	const Photon * GetIrradiancePhotons(unsigned int & count) const;
 
 	/// <summary> 
 	/// Finds the closest direct photon located within a given radius around a given world position
 	/// and sets photon to the found photon. If no photon is found then false is returned, else true.
 	/// </summary>
-	/// <param name='node'> The node to search around. </param>
+	/// <param name='pos'> The position to search around. </param>
 	/// <param name='radius'> The radius to search with. </param>
 	/// <param name='photonsInRadius'> Found photons are added to this vector. </param>
-	bool PhotonMap::GetClosestDirectPhotonAtPositionWithinRadius(const glm::vec3 & pos, const float radius, Photon & photon);
+	bool GetClosestDirectPhotonAtPositionWithinRadius(const glm::vec3 & pos, const float radius, Photon & photon) const;
 
 private:
-	/// <summary> Node used as reference to keep searching at in the kd tree. </summary>
-	PhotonMap::KDTreeNode directPhotonsReferenceNode;
-	PhotonMap::KDTreeNode indirectPhotonsReferenceNode;
-	PhotonMap::KDTreeNode shadowPhotonsReferenceNode;
-	PhotonMap::KDTreeNode causticsPhotonsReferenceNode;
-
-	KDTree::KDTree<3, KDTreeNode> directPhotonsKDTree;
-	KDTree::KDTree<3, KDTreeNode> indirectPhotonsKDTree;
-	KDTree::KDTree<3, KDTreeNode> shadowPhotonsKDTree;
-	KDTree::KDTree<3, KDTreeNode> causticsPhotonsKDTree;
+	/// <summary> The photons stored by a batch of photon paths. </summary>
+	struct PhotonBatch {
+		std::vector<Photon> directPhotons;
+		std::vector<Photon> indirectPhotons;
+		std::vector<Photon> shadowPhotons;
+		std::vector<Photon> causticsPhotons;
+	};
+
+	/// <summary> Traces the global (direct, indirect and shadow) photon paths [first, last) of light source i. </summary>
+	static void TraceGlobalPhotons(const class Scene & scene, const unsigned int i, const unsigned int first, const unsigned int last,
+								   const unsigned int MAX_DEPTH, const float INV_MAX_EMISSIVITY, PhotonBatch & batch);
+
+	/// <summary> Traces the caustics photon paths [first, last) of light source i, which are aimed at the transparent objects. </summary>
+	static void TraceCausticsPhotons(const class Scene & scene, const std::vector<const class RenderGroup*> & transparentObjects, const unsigned int i,
+									 const unsigned int first, const unsigned int last, const unsigned int MAX_DEPTH, PhotonBatch & batch);
+
+	/// <summary> Appends one kind of photons of all batches, in batch order, to a vector. </summary>
+	static void MergeBatches(const std::vector<PhotonBatch> & batches, std::vector<Photon> PhotonBatch::* photonsOfBatch, std::vector<Photon> & photons);
+
+	/// <summary> Estimates the irradiance at a surface point from the nearest direct and indirect photons. </summary>
+	glm::vec3 EstimateIrradiance(const glm::vec3 & pos, const glm::vec3 & normal) const;
+
+	/// <summary> Estimates the irradiance at a surface point from the nearest photons of one tree. </summary>
+	static glm::vec3 EstimateIrradiance(const PhotonKDTree & tree, const glm::vec3 & pos, const glm::vec3 & normal);
+
+	/// <summary> Returns a hash of the scene geometry, the materials and the photon settings, which identifies a cached photon map. </summary>
+	static uint64_t ComputeHash(const class Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_DEPTH, const bool PRECOMPUTE_IRRADIANCE);
+
+	/// <summary> Maps a cache file and uses its trees. Returns false if the file is missing or does not match the hash. </summary>
+	bool LoadFromFile(const std::string & path, const uint64_t hash);
+
+	/// <summary> Writes the trees to a cache file. Returns false if the file could not be written. </summary>
+	bool SaveToFile(const std::string & path, const uint64_t hash) const;
+
+	/// <summary> The mapped cache file which the trees use, if the photon map was loaded from a file. </summary>
+	Utility::MappedFile cacheFile;
+
+	PhotonKDTree directPhotonsKDTree;
+	PhotonKDTree indirectPhotonsKDTree;
+	PhotonKDTree shadowPhotonsKDTree;
+	PhotonKDTree causticsPhotonsKDTree;
+
+	/// <summary> Photons which hold the precomputed irradiance (as their color) at their position. </summary>
+	PhotonKDTree irradiancePhotonsKDTree;
 };
 
 
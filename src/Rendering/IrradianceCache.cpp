@@ -0,0 +1,91 @@
+#include "IrradianceCache.h"
+
+#include <algorithm>
+#include <mutex>
+
+#define __IN_FRONT_TOLERANCE 0.01f // Records further than this in front of a point are not used at the point.
+#define __MIN_ERROR 0.001f // Limits the weight of a record at its own position.
+
+IrradianceCache::IrradianceCache(const float _MAX_ERROR, const float _MIN_RADIUS, const float _MAX_RADIUS) :
+	MAX_ERROR(_MAX_ERROR), MIN_RADIUS(_MIN_RADIUS), MAX_RADIUS(_MAX_RADIUS), CELL_SIZE(_MAX_ERROR * _MAX_RADIUS),
+	lookupCount(0), hitCount(0) { }
+
+bool IrradianceCache::Interpolate(const glm::vec3 & position, const glm::vec3 & normal, glm::vec3 & irradiance) const {
+	++lookupCount;
+	const glm::ivec3 cell(glm::floor(position / CELL_SIZE));
+	glm::vec3 irradianceSum(0);
+	float weightSum = 0.0f;
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(mutex);
+		for (int x = cell.x - 1; x <= cell.x + 1; ++x) {
+			for (int y = cell.y - 1; y <= cell.y + 1; ++y) {
+				for (int z = cell.z - 1; z <= cell.z + 1; ++z) {
+					const auto records = cells.find(CellKey(x, y, z));
+					if (records == cells.end()) {
+						continue;
+					}
+					for (const Record & record : records->second) {
+						// The estimated error of using the record at the point (the inverse of Ward's weight).
+						const glm::vec3 offset = position - record.position;
+						const float distance = glm::length(offset);
+						const float error = distance / record.radius + std::sqrt(std::max(0.0f, 1.0f - glm::dot(normal, record.normal)));
+						if (error >= MAX_ERROR) {
+							continue;
+						}
+
+						// Records in front of the point may see surfaces which the point does not see.
+						if (glm::dot(offset, 0.5f * (normal + record.normal)) < -__IN_FRONT_TOLERANCE) {
+							continue;
+						}
+
+						// Extrapolate the irradiance of the record to the point using its gradients.
+						const glm::vec3 rotation = glm::cross(record.normal, normal);
+						glm::vec3 extrapolated;
+						for (unsigned int c = 0; c < 3; ++c) {
+							extrapolated[c] = record.irradiance[c] + glm::dot(rotation, record.rotationalGradient[c]) +
+								glm::dot(offset, record.translationalGradient[c]);
+						}
+						const float weight = 1.0f / std::max(error, __MIN_ERROR);
+						irradianceSum += weight * glm::max(extrapolated, glm::vec3(0));
+						weightSum += weight;
+					}
+				}
+			}
+		}
+	}
+	if (weightSum == 0.0f) {
+		return false;
+	}
+	++hitCount;
+	irradiance = irradianceSum / weightSum;
+	return true;
+}
+
+void IrradianceCache::Add(Record record) {
+	// Shrink the radius where the irradiance changes quickly, so that the
+	// extrapolation within the record's valid area stays small compared to its irradiance.
+	const float maxIrradiance = std::max(record.irradiance.r, std::max(record.irradiance.g, record.irradiance.b));
+	for (unsigned int c = 0; c < 3; ++c) {
+		const float gradientLength = glm::length(record.translationalGradient[c]);
+		if (gradientLength * record.radius > maxIrradiance) {
+			record.radius = maxIrradiance / gradientLength;
+		}
+	}
+	record.radius = glm::clamp(record.radius, MIN_RADIUS, MAX_RADIUS);
+
+	const glm::ivec3 cell(glm::floor(record.position / CELL_SIZE));
+	std::unique_lock<std::shared_timed_mutex> lock(mutex);
+	cells[CellKey(cell.x, cell.y, cell.z)].push_back(record);
+	++recordCount;
+}
+
+size_t IrradianceCache::Size() const {
+	std::shared_lock<std::shared_timed_mutex> lock(mutex);
+	return recordCount;
+}
+
+uint64_t IrradianceCache::CellKey(const int x, const int y, const int z) {
+	// 21 bits per coordinate, which is plenty for any scene at the cell sizes used.
+	const uint64_t mask = (1u << 21) - 1;
+	return ((static_cast<uint64_t>(x) & mask) << 42) | ((static_cast<uint64_t>(y) & mask) << 21) | (static_cast<uint64_t>(z) & mask);
+}
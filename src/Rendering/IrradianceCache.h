@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+
+#include <glm.hpp>
+
+/// <summary>
+/// A world space cache of irradiance estimates (Ward et al., "A Ray Tracing Solution for Diffuse Interreflection", 1988).
+/// Cached estimates are interpolated using their irradiance gradients (Ward and Heckbert, "Irradiance Gradients", 1992).
+/// The cache starts empty and is filled by the renderer, which adds a new record where no record is close enough.
+/// Any number of threads can look up and add records at once.
+/// </summary>
+class IrradianceCache {
+public:
+	/// <summary> An irradiance estimate at a surface point. </summary>
+	struct Record {
+		glm::vec3 position, normal, irradiance;
+		float radius; // The harmonic mean distance to the surfaces seen from the point.
+		glm::vec3 rotationalGradient[3]; // The change of each color channel when the normal is rotated.
+		glm::vec3 translationalGradient[3]; // The change of each color channel when the point is moved.
+	};
+
+	/// <param name='MAX_ERROR'> The largest allowed error of an interpolated record (a). Lower values give more records. </param>
+	/// <param name='MIN_RADIUS'> The smallest radius of a record (which limits the number of records in corners). </param>
+	/// <param name='MAX_RADIUS'> The largest radius of a record (which limits the interpolation in open areas). </param>
+	IrradianceCache(const float MAX_ERROR = 0.3f, const float MIN_RADIUS = 0.05f, const float MAX_RADIUS = 2.0f);
+
+	IrradianceCache(const IrradianceCache &) = delete;
+	IrradianceCache & operator=(const IrradianceCache &) = delete;
+
+	/// <summary>
+	/// Interpolates the irradiance at a surface point from the nearby records, weighted by their estimated error.
+	/// Returns false (a cache miss) if no record is valid at the point.
+	/// </summary>
+	bool Interpolate(const glm::vec3 & position, const glm::vec3 & normal, glm::vec3 & irradiance) const;
+
+	/// <summary> Adds a record. Its radius is clamped to the cache's limits and to the size of its gradient. </summary>
+	void Add(Record record);
+
+	/// <summary> Returns the number of records in the cache. </summary>
+	size_t Size() const;
+
+	/// <summary> Returns the number of calls to Interpolate so far. </summary>
+	uint64_t GetLookupCount() const { return lookupCount; }
+
+	/// <summary> Returns the number of calls to Interpolate which found a valid record. </summary>
+	uint64_t GetHitCount() const { return hitCount; }
+
+private:
+	const float MAX_ERROR, MIN_RADIUS, MAX_RADIUS;
+
+	/// <summary>
+	/// The records, bucketed by a uniform grid. A record is only valid within MAX_ERROR times its radius,
+	/// so the cells are that large (for the largest radius) and a lookup only visits the 27 cells around the point.
+	/// </summary>
+	const float CELL_SIZE;
+	std::unordered_map<uint64_t, std::vector<Record>> cells;
+	size_t recordCount = 0;
+
+	/// <summary> Guards the records. Lookups share the lock, while adding a record takes it exclusively. </summary>
+	mutable std::shared_timed_mutex mutex;
+
+	mutable std::atomic<uint64_t> lookupCount, hitCount;
+
+	/// <summary> Returns the key of the cell with the given integer coordinates. </summary>
+	static uint64_t CellKey(const int x, const int y, const int z);
+};
@@ -1,16 +1,17 @@
-#pragma once
-
-#include "Material.h"
-
-class OrenNayarMaterial : public Material {
-public:
-	OrenNayarMaterial(glm::vec3 color, float roughness = 0.5f, float emissivity = 0.0f,
-					  float reflectivity = 0.00f, float transparency = 0.0f, float refractiveIndex = 1.0f,
-					  float specularity = 0.0f, float specularExponent = 75.0f);
-	glm::vec3 GetSurfaceColor() const override;
-	glm::vec3 CalculateDiffuseLighting(const glm::vec3 & inDirection, const glm::vec3 & outDirection,
-									   const glm::vec3 & normal, const glm::vec3 & incomingIntensity) const override;
-private:
-	glm::vec3 surfaceColor;
-	float roughness;
+#pragma once
+
+#include "Material.h"
+
+class OrenNayarMaterial : public Material {
+public:
+	OrenNayarMaterial(glm::vec3 color, float roughness = 0.5f, float emissivity = 0.0f,
+					  float reflectivity = 0.00f, float transparency = 0.0f, float refractiveIndex = 1.0f,
+					  float specularity = 0.0f, float specularExponent = 75.0f);
+	glm::vec3 GetSurfaceColor() const override;
+	void AddToHash(Utility::Hash & hash) const override;
+	glm::vec3 CalculateDiffuseLighting(const glm::vec3 & inDirection, const glm::vec3 & outDirection,
+									   const glm::vec3 & normal, const glm::vec3 & incomingIntensity) const override;
+private:
+	glm::vec3 surfaceColor;
+	float roughness;
 };
\ No newline at end of file
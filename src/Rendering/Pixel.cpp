@@ -1,3 +1,3 @@
-#include "Pixel.h"
-
-Pixel::Pixel(glm::vec3 _color) : color(_color) { }
+#include "Pixel.h"
+
+Pixel::Pixel(glm::vec3 _color) : color(_color) { }
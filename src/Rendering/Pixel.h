@@ -1,11 +1,11 @@
-#pragma once
-
-#include <glm.hpp>
-
-#include "../Geometry/Ray.h"
-
-class Pixel {
-public:
-	glm::vec3 color;
-	Pixel(glm::vec3 color = glm::vec3());
+#pragma once
+
+#include <glm.hpp>
+
+#include "../Geometry/Ray.h"
+
+class Pixel {
+public:
+	glm::vec3 color;
+	Pixel(glm::vec3 color = glm::vec3());
 };
\ No newline at end of file
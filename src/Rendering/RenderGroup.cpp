@@ -1,26 +1,37 @@
-#include "RenderGroup.h"
-
-glm::vec3 RenderGroup::GetRandomPositionOnSurface() const {
-	const auto primitive = primitives[rand() % primitives.size()];
-	return primitive->GetRandomPositionOnSurface();
-}
-
-RenderGroup::RenderGroup(Material * mat) : material(mat) {}
-
-void RenderGroup::RecalculateAABB() {
-	glm::vec3 minimum = glm::vec3(FLT_MAX);
-	glm::vec3 maximum = glm::vec3(-FLT_MAX);
-	for (const auto & p : primitives) {
-		const auto & aabb = p->GetAxisAlignedBoundingBox();
-		const auto & amin = aabb.minimum;
-		const auto & amax = aabb.maximum;
-		minimum.x = glm::min<float>(minimum.x, amin.x);
-		minimum.y = glm::min<float>(minimum.y, amin.y);
-		minimum.z = glm::min<float>(minimum.z, amin.z);
-		maximum.x = glm::max<float>(maximum.x, amax.x);
-		maximum.y = glm::max<float>(maximum.y, amax.y);
-		maximum.z = glm::max<float>(maximum.z, amax.z);
-	}
-	axisAlignedBoundingBox.minimum = minimum;
-	axisAlignedBoundingBox.maximum = maximum;
-}
+#include "RenderGroup.h"
+
+glm::vec3 RenderGroup::GetRandomPositionOnSurface(Utility::RandomGenerator & random) const {
+	const auto primitive = primitives[random.NextUInt(static_cast<uint32_t>(primitives.size()))];
+	return primitive->GetRandomPositionOnSurface(random);
+}
+
+RenderGroup::RenderGroup(Material * mat) : material(mat) {}
+
+void RenderGroup::RecalculateArea() {
+	area = 0.0f;
+	for (const auto & p : primitives) {
+		area += p->GetArea();
+	}
+}
+
+float RenderGroup::GetPrimitiveSampleWeight(const Primitive * primitive) const {
+	return primitives.size() * primitive->GetArea() / area;
+}
+
+void RenderGroup::RecalculateAABB() {
+	glm::vec3 minimum = glm::vec3(FLT_MAX);
+	glm::vec3 maximum = glm::vec3(-FLT_MAX);
+	for (const auto & p : primitives) {
+		const auto & aabb = p->GetAxisAlignedBoundingBox();
+		const auto & amin = aabb.minimum;
+		const auto & amax = aabb.maximum;
+		minimum.x = glm::min<float>(minimum.x, amin.x);
+		minimum.y = glm::min<float>(minimum.y, amin.y);
+		minimum.z = glm::min<float>(minimum.z, amin.z);
+		maximum.x = glm::max<float>(maximum.x, amax.x);
+		maximum.y = glm::max<float>(maximum.y, amax.y);
+		maximum.z = glm::max<float>(maximum.z, amax.z);
+	}
+	axisAlignedBoundingBox.minimum = minimum;
+	axisAlignedBoundingBox.maximum = maximum;
+}
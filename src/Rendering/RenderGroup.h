@@ -1,23 +1,31 @@
-#pragma once
-
-#include <vector>
-#include <memory>
-
-#include "Materials\Material.h"
-#include "..\Geometry\Primitive.h"
-#include "..\PhotonMap\Photon.h"
-#include "..\Geometry\AABB.h"
-
-class RenderGroup {
-public:
-	bool enabled = true;
-	bool convex = true;
-	AABB axisAlignedBoundingBox;
-	Material* material;
-	std::vector<Primitive*> primitives;
-	std::vector<std::vector<Photon>> photons;
-
-	RenderGroup(Material*);
-	void RecalculateAABB();
-	glm::vec3 GetRandomPositionOnSurface() const;
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "Materials\Material.h"
+#include "..\Geometry\Primitive.h"
+#include "..\PhotonMap\Photon.h"
+#include "..\Geometry\AABB.h"
+
+class RenderGroup {
+public:
+	bool enabled = true;
+	bool convex = true;
+	AABB axisAlignedBoundingBox;
+	Material* material;
+	std::vector<Primitive*> primitives;
+	std::vector<std::vector<Photon>> photons;
+	float area = 0.0f; // The total surface area of the primitives (see RecalculateArea).
+
+	RenderGroup(Material*);
+	void RecalculateAABB();
+	void RecalculateArea();
+	glm::vec3 GetRandomPositionOnSurface(Utility::RandomGenerator & random) const;
+
+	/// <summary>
+	/// Returns the weight of a point sampled on the given primitive, when the primitive is chosen uniformly by index.
+	/// The weight is the primitive's area relative to the average primitive, which makes the samples uniform by area.
+	/// </summary>
+	float GetPrimitiveSampleWeight(const Primitive * primitive) const;
 };
\ No newline at end of file
@@ -1,172 +1,390 @@
-#include "MonteCarloRenderer.h"
-
-#include "../../Utility/Math.h"
-#include "../../includes/glm/gtx/norm.hpp"
-#include "../../Utility/Rendering.h"
-
-#define __USE_SPECULAR_LIGHTING true
-
-glm::vec3 MonteCarloRenderer::GetPixelColor(const Ray & ray) {
-	return TraceRay(ray);
-}
-
-MonteCarloRenderer::MonteCarloRenderer(Scene & _scene, const unsigned int _MAX_DEPTH) :
-	MAX_DEPTH(_MAX_DEPTH), Renderer("Monte Carlo Renderer", _scene) { }
-
-glm::vec3 MonteCarloRenderer::TraceRay(const Ray & _ray, const unsigned int DEPTH) {
-	if (DEPTH == MAX_DEPTH) {
-		return glm::vec3(0);
-	}
-
-	assert(DEPTH >= 0 && DEPTH < MAX_DEPTH);
-	assert(glm::length(ray.direction) > 1.0f - 10.0f * FLT_EPSILON && glm::length(ray.direction) < 1.0f + 10.0f * FLT_EPSILON);
-
-	// Nudge the ray a little bit. 
-	// This is not really required, but it removes some unnecessary "misses" (due to floating point errors).
-	Ray ray(_ray.from + 0.001f * _ray.direction, _ray.direction);
-
-	// See if our current ray hits anything in the scene.
-	float intersectionDistance;
-	unsigned int intersectionPrimitiveIndex, intersectionRenderGroupIndex;
-	const bool intersectionFound = scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance);
-
-	// If the ray doesn't intersect, simply return (0, 0, 0).
-	if (!intersectionFound) {
-		return glm::vec3(0);
-	}
-
-	// Calculate intersection point.
-	const glm::vec3 intersectionPoint = ray.from + ray.direction * intersectionDistance;
-
-	// Retrieve primitive information for the intersected object. 
-	auto & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
-	const auto & intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-
-	// Calculate hit normal.
-	const glm::vec3 hitNormal = intersectionPrimitive->GetNormal(intersectionPoint);
-	if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON) {
-		return glm::vec3(0); // Back face culling.
-	}
-
-	// Retrieve the intersected surface's material.
-	const Material * const hitMaterial = intersectionRenderGroup.material;
-
-	// -------------------------------
-	// Emissive lighting.
-	// -------------------------------
-	if (hitMaterial->IsEmissive()) {
-		float f = 1.0f;
-		if (DEPTH >= 1) {
-			f *= glm::dot(-ray.direction, hitNormal);
-		}
-		auto self = hitMaterial->CalculateDiffuseLighting(-hitNormal, -ray.direction, hitNormal, hitMaterial->GetEmissionColor());
-		return f * hitMaterial->GetEmissionColor() + self;
-	}
-
-	// Initialize color accumulator.
-	glm::vec3 colorAccumulator = glm::vec3(0);
-	const float rf = 1.0f - hitMaterial->reflectivity;
-	const float tf = 1.0f - hitMaterial->transparency;
-
-	// -------------------------------
-	// Direct lighting.
-	// -------------------------------
-	if (rf > FLT_EPSILON && tf > FLT_EPSILON) {
-		for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
-
-			// Create a shadow ray.
-			const glm::vec3 randomLightSurfacePosition = lightSource->GetRandomPositionOnSurface();
-			const glm::vec3 shadowRayDirection = glm::normalize(randomLightSurfacePosition - intersectionPoint);
-			if (glm::dot(shadowRayDirection, hitNormal) < FLT_EPSILON) {
-				continue;
-			}
-			const Ray shadowRay(intersectionPoint + hitNormal * 0.0001f, shadowRayDirection);
-
-			// Cast the shadow ray towards the light source.
-			unsigned int shadowRayGroupIndex, shadowRayPrimitiveIndex;
-			if (scene.RayCast(shadowRay, shadowRayGroupIndex, shadowRayPrimitiveIndex, intersectionDistance)) {
-				const auto & renderGroup = scene.renderGroups[shadowRayGroupIndex];
-				if (&renderGroup == lightSource) {
-
-					// We hit the light. Add it's contribution to the color accumulator.
-					const Primitive * lightPrimitive = renderGroup.primitives[shadowRayPrimitiveIndex];
-					const glm::vec3 lightNormal = lightPrimitive->GetNormal(shadowRay.from + intersectionDistance * shadowRay.direction);
-					float lightFactor = glm::dot(-shadowRay.direction, lightNormal);
-					if (lightFactor < FLT_EPSILON) {
-						continue;
-					}
-
-					// Direct diffuse lighting.
-					const glm::vec3 radiance = lightFactor * lightSource->material->GetEmissionColor();
-					colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
-
-#if __USE_SPECULAR_LIGHTING
-					// Specular lighting.
-					if (hitMaterial->IsSpecular()) {
-						colorAccumulator += hitMaterial->CalculateSpecularLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
-					}
-#endif
-				}
-			}
-		}
-	}
-
-	colorAccumulator *= (1.0f / glm::max<float>(1.0f, (float)scene.emissiveRenderGroups.size()));
-
-	// -------------------------------
-	// Indirect lighting.
-	// -------------------------------
-	if (rf > FLT_EPSILON && tf > FLT_EPSILON) {
-		// Shoot rays and integrate diffuse lighting based on BRDF to compute indirect lighting. 
-		const glm::vec3 reflectionDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(hitNormal);
-		assert(dot(reflectionDirection, hitNormal) > -FLT_EPSILON);
-		const Ray diffuseRay(intersectionPoint, reflectionDirection);
-		const auto incomingRadiance = TraceRay(diffuseRay, DEPTH + 1);
-		colorAccumulator += hitMaterial->CalculateDiffuseLighting(-diffuseRay.direction, -ray.direction, hitNormal, incomingRadiance);
-	}
-
-	colorAccumulator *= rf * tf;
-
-	// -------------------------------
-	// Refracted lighting.
-	// -------------------------------
-	if (hitMaterial->IsTransparent()) {
-		// Fetch refractive data.
-		const float n1 = 1.0f;
-		const float n2 = hitMaterial->refractiveIndex;
-		const float schlickConstantOutside = Utility::Rendering::CalculateSchlicksApproximation(ray.direction, hitNormal, n1, n2);
-		float schlickConstantInside = schlickConstantOutside;
-
-		// Refract ray.
-		glm::vec3 offset = hitNormal * 0.001f;
-		Ray refractedRay(intersectionPoint - offset, glm::refract(ray.direction, hitNormal, n1 / n2));
-		if (scene.RenderGroupRayCast(refractedRay, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
-			const auto & refractedRayHitPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-			const glm::vec3 refractedIntersectionPoint = refractedRay.from + refractedRay.direction * intersectionDistance;
-			const glm::vec3 refractedHitNormal = refractedRayHitPrimitive->GetNormal(refractedIntersectionPoint);
-			schlickConstantInside = Utility::Rendering::CalculateSchlicksApproximation(refractedRay.direction, -refractedHitNormal, n2, n1);
-			Ray refractedRayOut(refractedIntersectionPoint + 0.01f * refractedHitNormal, glm::refract(refractedRay.direction, -refractedHitNormal, n2 / n1));
-			const float f1 = (1.0f - schlickConstantOutside) * (hitMaterial->transparency);
-			const float f2 = (1.0f - schlickConstantInside);
-			const auto incomingRadiance = f2 * TraceRay(refractedRayOut, DEPTH + 1);
-			colorAccumulator += f1 * hitMaterial->CalculateDiffuseLighting(refractedRay.direction, -ray.direction, hitNormal, incomingRadiance);
-		}
-		else {
-			colorAccumulator += (1.0f - schlickConstantOutside) * (hitMaterial->transparency) * TraceRay(refractedRay, DEPTH + 1);
-		}
-		Ray specularRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
-		const float sf = schlickConstantOutside * hitMaterial->specularity;
-		colorAccumulator += sf * hitMaterial->CalculateSpecularLighting(-specularRay.direction, -ray.direction, hitNormal, TraceRay(specularRay, DEPTH + 1));
-	}
-
-	// -------------------------------
-	// Perfectly reflective lighting.
-	// -------------------------------
-	if (hitMaterial->IsReflective()) {
-		Ray reflectedRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
-		colorAccumulator += hitMaterial->reflectivity * TraceRay(reflectedRay, DEPTH + 1);
-	}
-
-	// Return result.
-	return colorAccumulator;
-}
+#include "MonteCarloRenderer.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "../../Utility/Math.h"
+#include "../../includes/glm/gtx/norm.hpp"
+#include "../../Utility/Rendering.h"
+#include "../../PhotonMap/PhotonGuidingDistribution.h"
+#include "../RenderingConstants.h"
+
+#define __USE_SPECULAR_LIGHTING true
+#define __USE_PATH_GUIDING false // Learn the incident radiance in an SD-tree over progressive passes, and sample the indirect bounces from it.
+#define __USE_PHOTON_GUIDING false // Sample the indirect bounces from the incoming directions of nearby photons (and the cosine lobe).
+
+namespace {
+	/// <summary> A diffuse bounce of a path, which trains the SD-tree with the radiance arriving along the rest of the path. </summary>
+	struct GuidingVertex {
+		glm::vec3 position, direction;
+		float pdf; // The pdf of the direction.
+		glm::vec3 throughput; // The throughput of the path after the bounce.
+		glm::vec3 radiance; // The radiance which has arrived along the direction so far.
+	};
+}
+
+glm::vec3 MonteCarloRenderer::GetPixelColor(const Ray & ray, Sampler & sampler) {
+	return TraceRay(ray, sampler);
+}
+
+bool MonteCarloRenderer::TracesPackets() const {
+	return true;
+}
+
+glm::vec3 MonteCarloRenderer::TraceCameraRay(const Ray & ray, Sampler & sampler, const Intersection & intersection) {
+	return TraceRay(ray, sampler, &intersection);
+}
+
+MonteCarloRenderer::MonteCarloRenderer(Scene & _scene, const unsigned int _MAX_DEPTH, const unsigned int PHOTONS_PER_LIGHT_SOURCE,
+									   const unsigned int MAX_PHOTON_DEPTH) :
+	Renderer("Monte Carlo Renderer", _scene), MAX_DEPTH(_MAX_DEPTH), sdTree(_scene.axisAlignedBoundingBox) {
+#if __USE_PHOTON_GUIDING
+	photonMap.reset(new PhotonMap(_scene, PHOTONS_PER_LIGHT_SOURCE, MAX_PHOTON_DEPTH));
+#else
+	// The photon map settings are only used for photon guiding.
+	(void)PHOTONS_PER_LIGHT_SOURCE;
+	(void)MAX_PHOTON_DEPTH;
+#endif
+}
+
+glm::vec3 MonteCarloRenderer::TraceRay(const Ray & cameraRay, Sampler & sampler, const Intersection * const cameraIntersection) {
+	// The throughput is the factor by which radiance arriving along the current ray adds to the pixel.
+	glm::vec3 pathRadiance(0), throughput(1.0f);
+	std::vector<GuidingVertex> guidingVertices;
+	const auto AddRadiance = [&](const glm::vec3 & radiance) {
+		pathRadiance += throughput * radiance;
+		for (GuidingVertex & vertex : guidingVertices) {
+			vertex.radiance += throughput * radiance / glm::max(vertex.throughput, glm::vec3(FLT_MIN));
+		}
+	};
+
+	Ray ray = cameraRay;
+	const Intersection * intersection = cameraIntersection;
+	for (unsigned int depth = 0; depth < MAX_DEPTH; ++depth) {
+		assert(glm::length(ray.direction) > 1.0f - 10.0f * FLT_EPSILON && glm::length(ray.direction) < 1.0f + 10.0f * FLT_EPSILON);
+
+		// Nudge the ray a little bit. 
+		// This is not really required, but it removes some unnecessary "misses" (due to floating point errors).
+		ray = Ray(ray.from + __RAY_NUDGE_DISTANCE * ray.direction, ray.direction);
+
+		// See if our current ray hits anything in the scene. Only the camera ray's hit can be known in advance.
+		float intersectionDistance;
+		unsigned int intersectionPrimitiveIndex, intersectionRenderGroupIndex;
+		bool intersectionFound;
+		if (intersection != nullptr) {
+			intersectionRenderGroupIndex = intersection->renderGroupIndex;
+			intersectionPrimitiveIndex = intersection->primitiveIndex;
+			intersectionDistance = intersection->distance;
+			intersectionFound = intersectionDistance != FLT_MAX;
+			intersection = nullptr;
+		}
+		else {
+			intersectionFound = scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance);
+		}
+
+		// If the ray doesn't intersect, the path ends.
+		if (!intersectionFound) {
+			break;
+		}
+
+		// Calculate intersection point.
+		const glm::vec3 intersectionPoint = ray.from + ray.direction * intersectionDistance;
+
+		// Retrieve primitive information for the intersected object. 
+		auto & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+		const auto & intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+
+		// Calculate hit normal.
+		const glm::vec3 hitNormal = intersectionPrimitive->GetNormal(intersectionPoint);
+		if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON) {
+			break; // Back face culling.
+		}
+
+		// Retrieve the intersected surface's material.
+		const Material * const hitMaterial = intersectionRenderGroup.material;
+
+		// -------------------------------
+		// Emissive lighting.
+		// -------------------------------
+		if (hitMaterial->IsEmissive()) {
+			float f = 1.0f;
+			if (depth >= 1) {
+				f *= glm::dot(-ray.direction, hitNormal);
+			}
+			auto self = hitMaterial->CalculateDiffuseLighting(-hitNormal, -ray.direction, hitNormal, hitMaterial->GetEmissionColor());
+			AddRadiance(f * hitMaterial->GetEmissionColor() + self);
+			break;
+		}
+
+		const float rf = 1.0f - hitMaterial->reflectivity;
+		const float tf = 1.0f - hitMaterial->transparency;
+
+		// -------------------------------
+		// Direct lighting.
+		// -------------------------------
+		if (rf > FLT_EPSILON && tf > FLT_EPSILON) {
+			glm::vec3 directLighting(0);
+			for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
+
+				// Sample a point on the light source (weighted to be uniform by area).
+				const Primitive * lightPrimitive = lightSource->primitives[sampler.GetIndex(static_cast<unsigned int>(lightSource->primitives.size()))];
+				const glm::vec3 randomLightSurfacePosition = lightPrimitive->GetPositionOnSurface(sampler.Get2D());
+				const glm::vec3 lightNormal = lightPrimitive->GetNormal(randomLightSurfacePosition);
+				const glm::vec3 shadowRayOrigin = intersectionPoint + hitNormal * __SHADOW_RAY_ORIGIN_OFFSET;
+				const float lightDistance = glm::length(randomLightSurfacePosition - shadowRayOrigin);
+				const glm::vec3 shadowRayDirection = (randomLightSurfacePosition - shadowRayOrigin) / lightDistance;
+				if (glm::dot(shadowRayDirection, hitNormal) < FLT_EPSILON) {
+					continue;
+				}
+				float lightFactor = glm::dot(-shadowRayDirection, lightNormal);
+				if (lightFactor < FLT_EPSILON) {
+					continue;
+				}
+
+				// Cast the shadow ray towards the light source. Only blockers in front of the light point matter.
+				const Ray shadowRay(shadowRayOrigin, shadowRayDirection);
+				if (scene.Occluded(shadowRay, lightDistance - __SHADOW_RAY_LIGHT_OFFSET)) {
+					continue;
+				}
+
+				// The light is visible. Add it's contribution to the direct lighting.
+				const glm::vec3 radiance = lightFactor * lightSource->GetPrimitiveSampleWeight(lightPrimitive) * lightSource->material->GetEmissionColor();
+				directLighting += rf * tf * hitMaterial->CalculateDiffuseLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
+
+#if __USE_SPECULAR_LIGHTING
+				// Specular lighting.
+				if (hitMaterial->IsSpecular()) {
+					directLighting += hitMaterial->CalculateSpecularLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
+				}
+#endif
+			}
+			AddRadiance(rf * tf * directLighting / glm::max<float>(1.0f, (float)scene.emissiveRenderGroups.size()));
+		}
+
+		// -------------------------------
+		// Continuation of the path.
+		// -------------------------------
+		// The path continues along one of the diffuse, refracted, specular and perfectly reflected rays, chosen by the fraction
+		// of the light it carries (so Fresnel chooses between reflection and refraction). The throughput is divided by the
+		// probability of the choice.
+		float schlickConstantOutside = 0.0f;
+		if (hitMaterial->IsTransparent()) {
+			schlickConstantOutside = Utility::Rendering::CalculateSchlicksApproximation(ray.direction, hitNormal, 1.0f, hitMaterial->refractiveIndex);
+		}
+		const float continuationWeights[CONTINUATION_COUNT] = {
+			rf > FLT_EPSILON && tf > FLT_EPSILON ? rf * tf : 0.0f,
+			hitMaterial->IsTransparent() ? (1.0f - schlickConstantOutside) * hitMaterial->transparency : 0.0f,
+			hitMaterial->IsTransparent() ? schlickConstantOutside * hitMaterial->specularity : 0.0f,
+			hitMaterial->IsReflective() ? hitMaterial->reflectivity : 0.0f
+		};
+		float weightSum = 0.0f;
+		for (unsigned int i = 0; i < CONTINUATION_COUNT; ++i) {
+			weightSum += continuationWeights[i];
+		}
+		if (weightSum <= 0.0f) {
+			break;
+		}
+		float choice = sampler.Get1D() * weightSum;
+		unsigned int continuation = 0;
+		for (unsigned int i = 0; i < CONTINUATION_COUNT; ++i) {
+			if (continuationWeights[i] > 0.0f) {
+				continuation = i; // The last possible continuation also takes choices beyond the sum through rounding.
+				if (choice < continuationWeights[i]) {
+					break;
+				}
+				choice -= continuationWeights[i];
+			}
+		}
+		const float choiceProbability = continuationWeights[continuation] / weightSum;
+
+		if (continuation == DIFFUSE) {
+			// Integrate diffuse lighting based on BRDF to compute indirect lighting.
+			// With guiding, the weight corrects for sampling some directions more often than the cosine lobe does.
+			glm::vec3 reflectionDirection;
+			float guidingWeight = 1.0f;
+#if __USE_PATH_GUIDING
+			float directionPdf = 0.0f;
+			reflectionDirection = SampleGuidedDirection(intersectionPoint, hitNormal, sampler, guidingWeight, directionPdf);
+#else
+			if (photonMap != nullptr) {
+				const PhotonGuidingDistribution guidingDistribution(*photonMap, intersectionPoint, hitNormal, GUIDING_PHOTON_COUNT, GUIDING_PHOTON_RADIUS);
+				const float guidingChoice = sampler.Get1D();
+				reflectionDirection = guidingDistribution.Sample(guidingChoice, sampler.Get2D(), guidingWeight);
+			}
+			else {
+				reflectionDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(hitNormal, sampler.Get2D());
+			}
+#endif
+			if (guidingWeight <= 0.0f) {
+				break;
+			}
+			assert(dot(reflectionDirection, hitNormal) > -FLT_EPSILON);
+			throughput *= rf * tf * guidingWeight / choiceProbability *
+				hitMaterial->CalculateDiffuseLighting(-reflectionDirection, -ray.direction, hitNormal, glm::vec3(1.0f));
+#if __USE_PATH_GUIDING
+			// The radiance which arrives along the rest of the path trains the SD-tree.
+			guidingVertices.push_back({ intersectionPoint, reflectionDirection, directionPdf, throughput, glm::vec3(0) });
+#endif
+			ray = Ray(intersectionPoint, reflectionDirection);
+		}
+		else if (continuation == REFRACTED) {
+			// Refract the ray into the surface, and out of its render group if it is hit again.
+			const float n1 = 1.0f;
+			const float n2 = hitMaterial->refractiveIndex;
+			glm::vec3 offset = hitNormal * 0.001f;
+			Ray refractedRay(intersectionPoint - offset, glm::refract(ray.direction, hitNormal, n1 / n2));
+			if (scene.RenderGroupRayCast(refractedRay, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+				const auto & refractedRayHitPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+				const glm::vec3 refractedIntersectionPoint = refractedRay.from + refractedRay.direction * intersectionDistance;
+				const glm::vec3 refractedHitNormal = refractedRayHitPrimitive->GetNormal(refractedIntersectionPoint);
+				const float schlickConstantInside = Utility::Rendering::CalculateSchlicksApproximation(refractedRay.direction, -refractedHitNormal, n2, n1);
+				const float f1 = (1.0f - schlickConstantOutside) * (hitMaterial->transparency);
+				const float f2 = (1.0f - schlickConstantInside);
+				throughput *= f1 / choiceProbability *
+					hitMaterial->CalculateDiffuseLighting(refractedRay.direction, -ray.direction, hitNormal, glm::vec3(f2));
+				ray = Ray(refractedIntersectionPoint + 0.01f * refractedHitNormal, glm::refract(refractedRay.direction, -refractedHitNormal, n2 / n1));
+			}
+			else {
+				throughput *= weightSum;
+				ray = refractedRay;
+			}
+		}
+		else if (continuation == SPECULAR) {
+			const Ray specularRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
+			throughput *= weightSum * hitMaterial->CalculateSpecularLighting(-specularRay.direction, -ray.direction, hitNormal, glm::vec3(1.0f));
+			ray = specularRay;
+		}
+		else {
+			// Perfectly reflective lighting.
+			throughput *= weightSum;
+			ray = Ray(intersectionPoint, glm::reflect(ray.direction, hitNormal));
+		}
+
+		// Russian roulette: after RUSSIAN_ROULETTE_DEPTH bounces, the path ends with a probability which grows as its
+		// throughput falls, and the throughput of surviving paths makes up for the ended ones.
+		const float survivalProbability = std::min(1.0f, std::max(throughput.r, std::max(throughput.g, throughput.b)));
+		if (survivalProbability <= 0.0f) {
+			break;
+		}
+		if (depth + 1 >= RUSSIAN_ROULETTE_DEPTH && survivalProbability < 1.0f) {
+			if (sampler.Get1D() >= survivalProbability) {
+				break;
+			}
+			throughput /= survivalProbability;
+		}
+	}
+
+#if __USE_PATH_GUIDING
+	// Train the SD-tree with the radiance which arrived at every diffuse bounce along the finished path.
+	for (const GuidingVertex & vertex : guidingVertices) {
+		const float radiance = (vertex.radiance.r + vertex.radiance.g + vertex.radiance.b) / 3.0f;
+		sdTree.Record(vertex.position, vertex.direction, radiance / vertex.pdf);
+	}
+#endif
+	return pathRadiance;
+}
+
+glm::vec3 MonteCarloRenderer::SampleGuidedDirection(const glm::vec3 & position, const glm::vec3 & normal, Sampler & sampler, float & weight, float & pdf) const {
+	// Until the SD-tree has learned anything at the point, only the cosine lobe is sampled.
+	const DTree & guide = sdTree.GetSamplingTree(position);
+	const float cosineFraction = guide.HasEnergy() ? GUIDED_COSINE_FRACTION : 1.0f;
+	const float choice = sampler.Get1D();
+	const glm::vec2 u = sampler.Get2D();
+	const glm::vec3 direction = choice < cosineFraction ? Utility::Math::CosineWeightedHemisphereSampleDirection(normal, u) : guide.Sample(u);
+
+	const float cosTheta = glm::dot(direction, normal);
+	if (cosTheta <= 0.0f) {
+		weight = pdf = 0.0f;
+		return direction;
+	}
+	const float cosinePdf = cosTheta / glm::pi<float>();
+	pdf = cosineFraction * cosinePdf;
+	if (cosineFraction < 1.0f) {
+		pdf += (1.0f - cosineFraction) * guide.Pdf(direction);
+	}
+	weight = cosinePdf / pdf;
+	return direction;
+}
+
+bool MonteCarloRenderer::IsProgressive() const {
+	return __USE_PATH_GUIDING;
+}
+
+void MonteCarloRenderer::BeginPasses(const unsigned int _width, const unsigned int _height, const unsigned int _passCount) {
+	width = _width;
+	height = _height;
+	passCount = iteration = iterationPassCount = 0;
+	pixelColors.assign(width * height, glm::vec3(0));
+	pixelSquares.assign(width * height, 0.0f);
+	imageColors.assign(width * height, glm::vec3(0));
+	imageWeight = 0.0;
+
+	// The last iteration gets all remaining passes if they are too few for two more iterations.
+	iterationEnds.clear();
+	unsigned int start = 0, length = 1;
+	while (start < _passCount) {
+		if (_passCount - start < 3 * length) {
+			length = _passCount - start;
+		}
+		start += length;
+		iterationEnds.push_back(start);
+		length *= 2;
+	}
+}
+
+void MonteCarloRenderer::TracePassRay(const Ray & ray, const float weight, Sampler & sampler, const unsigned int x, const unsigned int y) {
+	const glm::vec3 color = weight * TraceRay(ray, sampler);
+	const float intensity = (color.r + color.g + color.b) / 3.0f;
+	pixelColors[x * height + y] += color;
+	pixelSquares[x * height + y] += intensity * intensity;
+}
+
+void MonteCarloRenderer::EndPass(Utility::ThreadPool &) {
+	++passCount;
+	++iterationPassCount;
+	if (passCount == iterationEnds[iteration]) {
+		AddIterationToImage();
+		if (iteration + 1 < iterationEnds.size()) {
+			sdTree.Refine(iteration++);
+		}
+	}
+}
+
+void MonteCarloRenderer::AddIterationToImage() {
+	const float n = static_cast<float>(iterationPassCount);
+	double variance = 0.0;
+	if (iterationPassCount >= 2) {
+		for (size_t i = 0; i < pixelColors.size(); ++i) {
+			const float mean = (pixelColors[i].r + pixelColors[i].g + pixelColors[i].b) / (3.0f * n);
+			variance += std::max(0.0f, pixelSquares[i] / n - mean * mean) / (n - 1.0f);
+		}
+		variance /= pixelColors.size();
+	}
+	const bool isLastIteration = iteration + 1 == iterationEnds.size();
+	const double weight = variance > 0.0 ? 1.0 / variance : (isLastIteration && imageWeight == 0.0 ? 1.0 : 0.0);
+	if (weight > 0.0) {
+		for (size_t i = 0; i < pixelColors.size(); ++i) {
+			imageColors[i] += static_cast<float>(weight / n) * pixelColors[i];
+		}
+		imageWeight += weight;
+	}
+	iterationPassCount = 0;
+	std::fill(pixelColors.begin(), pixelColors.end(), glm::vec3(0));
+	std::fill(pixelSquares.begin(), pixelSquares.end(), 0.0f);
+}
+
+glm::vec3 MonteCarloRenderer::GetPassPixelColor(const unsigned int x, const unsigned int y) const {
+	return imageWeight > 0.0 ? imageColors[x * height + y] / static_cast<float>(imageWeight) : glm::vec3(0);
+}
+
+void MonteCarloRenderer::WriteStatistics(std::ostream & out, const unsigned int COL_WIDTH) const {
+#if __USE_PATH_GUIDING
+	out << std::setw(COL_WIDTH) << std::left << "SD-tree iterations:" << iterationEnds.size() << std::endl;
+	out << std::setw(COL_WIDTH) << std::left << "SD-tree spatial leaves:" << sdTree.GetLeafCount() << std::endl;
+	out << std::setw(COL_WIDTH) << std::left << "SD-tree mean quadtree nodes:" << sdTree.GetMeanDirectionalNodeCount() << std::endl;
+#else
+	// There are no statistics without path guiding.
+	(void)out;
+	(void)COL_WIDTH;
+#endif
+}
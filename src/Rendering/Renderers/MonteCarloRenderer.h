@@ -1,17 +1,75 @@
-#pragma once
-
-#include <vector>
-
-#include "Renderer.h"
-#include "../../Scene/Scene.h"
-
-class MonteCarloRenderer : public Renderer {
-public:
-	glm::vec3 GetPixelColor(const Ray & ray) override;
-	MonteCarloRenderer(Scene & scene, const unsigned int MAX_DEPTH = 5);
-private:
-	const unsigned int MAX_DEPTH;
-
-	/// <summary> Traces a ray through the scene. </summary>
-	glm::vec3 TraceRay(const Ray & ray, const unsigned int DEPTH = 0);
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Renderer.h"
+#include "../SDTree.h"
+#include "../../Scene/Scene.h"
+
+class MonteCarloRenderer : public Renderer {
+public:
+	glm::vec3 GetPixelColor(const Ray & ray, Sampler & sampler) override;
+	bool TracesPackets() const override;
+	glm::vec3 TraceCameraRay(const Ray & ray, Sampler & sampler, const Intersection & intersection) override;
+	/// <param name='PHOTONS_PER_LIGHT_SOURCE'> The photons per light source of the photon map which guides the indirect bounces. </param>
+	/// <param name='MAX_PHOTON_DEPTH'> The number of surfaces a guiding photon can hit (at most). </param>
+	MonteCarloRenderer(Scene & scene, const unsigned int MAX_DEPTH = 5, const unsigned int PHOTONS_PER_LIGHT_SOURCE = 100000,
+					   const unsigned int MAX_PHOTON_DEPTH = 3);
+
+	/// <summary> The renderer is progressive when path guiding is used, so that the SD-tree can be trained between passes. </summary>
+	bool IsProgressive() const override;
+	void BeginPasses(const unsigned int width, const unsigned int height, const unsigned int passCount) override;
+	void TracePassRay(const Ray & ray, const float weight, Sampler & sampler, const unsigned int x, const unsigned int y) override;
+	void EndPass(Utility::ThreadPool & threadPool) override;
+	glm::vec3 GetPassPixelColor(const unsigned int x, const unsigned int y) const override;
+	void WriteStatistics(std::ostream & out, const unsigned int COL_WIDTH) const override;
+private:
+	const unsigned int MAX_DEPTH;
+	const unsigned int RUSSIAN_ROULETTE_DEPTH = 2; // The number of bounces after which paths may end at random.
+	const float GUIDED_COSINE_FRACTION = 0.5f; // The fraction of the guided bounces which are cosine-weighted instead of drawn from the SD-tree.
+	const unsigned int GUIDING_PHOTON_COUNT = 64; // The number of direct and of indirect photons which guide a bounce.
+	const float GUIDING_PHOTON_RADIUS = 0.5f; // The largest distance to the photons which guide a bounce.
+	std::unique_ptr<const PhotonMap> photonMap; // The photon map which guides the indirect bounces (nullptr if guiding is not used).
+
+	/// <summary> The incident radiance learned from the paths of earlier passes (when path guiding is used). </summary>
+	SDTree sdTree;
+
+	/// <summary>
+	/// The number of passes after which each training iteration of the SD-tree ends. Every iteration is twice as long as
+	/// the one before, except the last, which gets all remaining passes.
+	/// </summary>
+	std::vector<unsigned int> iterationEnds;
+	unsigned int width = 0, height = 0, passCount = 0, iteration = 0, iterationPassCount = 0;
+
+	/// <summary> The sums of the pixel colors and of their squared intensities in the current iteration. </summary>
+	std::vector<glm::vec3> pixelColors;
+	std::vector<float> pixelSquares;
+
+	/// <summary> The images of the finished iterations, weighted by the inverse of their variance, and the sum of the weights. </summary>
+	std::vector<glm::vec3> imageColors;
+	double imageWeight = 0.0;
+
+	/// <summary> The rays which a path can continue along at a hit. </summary>
+	enum Continuation { DIFFUSE, REFRACTED, SPECULAR, REFLECTED, CONTINUATION_COUNT };
+
+	/// <summary>
+	/// Traces a path from a camera ray through the scene, and returns the radiance which it carries to the camera.
+	/// At every hit the path continues along a single ray, and ends at random (Russian roulette) when it carries little light.
+	/// </summary>
+	/// <param name='intersection'> The closest intersection of the (nudged) ray if it is already known, otherwise nullptr. </param>
+	glm::vec3 TraceRay(const Ray & ray, Sampler & sampler, const Intersection * const intersection = nullptr);
+
+	/// <summary>
+	/// Samples a bounce direction from the SD-tree at a surface point mixed with the cosine lobe, and returns the pdf of the direction.
+	/// The weight is the cosine-weighted pdf divided by the pdf (0 for directions below the surface).
+	/// </summary>
+	glm::vec3 SampleGuidedDirection(const glm::vec3 & position, const glm::vec3 & normal, Sampler & sampler, float & weight, float & pdf) const;
+
+	/// <summary>
+	/// Adds the image of the finished iteration to the final image, weighted by the inverse of its estimated variance
+	/// (the mean variance of its pixels), and starts a new iteration. Iterations of a single pass have no variance estimate,
+	/// so they are only used if the image would otherwise be empty.
+	/// </summary>
+	void AddIterationToImage();
 };
\ No newline at end of file
@@ -1,271 +1,526 @@
-#include "PhotonMapRenderer.h"
-
-#include <algorithm>
-
-#include "../../Utility/Rendering.h"
-#include "../../Utility/Math.h"
-
-#define __USE_SPECULAR_LIGHTING false
-#define __USE_CAUSTICS_PHOTON_MAP true
-#define __USE_GLOBAL_PHOTON_MAP true
-
-glm::vec3 PhotonMapRenderer::GetPixelColor(const Ray & ray) {
-	return TraceRay(ray);
-}
-
-PhotonMapRenderer::PhotonMapRenderer(Scene & _scene, const unsigned int _MAX_DEPTH, const unsigned int _BOUNCES_PER_HIT,
-									 const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_PHOTON_DEPTH) :
-	MAX_DEPTH(_MAX_DEPTH), BOUNCES_PER_HIT(_BOUNCES_PER_HIT), Renderer("Photon Map Renderer", _scene) {
-	photonMap = new PhotonMap(_scene, PHOTONS_PER_LIGHT_SOURCE, MAX_PHOTON_DEPTH);
-}
-
-glm::vec3 PhotonMapRenderer::TraceRay(const Ray & _ray, const unsigned int DEPTH) {
-	if (DEPTH == MAX_DEPTH) {
-		return glm::vec3(0);
-	}
-
-	// Nudge the ray a little bit. 
-	// This is not really required, but it removes some unnecessary "misses" (due to floating point errors).
-	Ray ray(_ray.from + 0.001f * _ray.direction, _ray.direction);
-
-	assert(DEPTH >= 0 && DEPTH < MAX_DEPTH);
-	assert(glm::length(ray.direction) > 1.0f - 10.0f * FLT_EPSILON && glm::length(ray.direction) < 1.0f + 10.0f * FLT_EPSILON);
-
-	// See if our current ray hits anything in the scene.
-	float intersectionDistance;
-	unsigned int intersectionPrimitiveIndex, intersectionRenderGroupIndex;
-	const bool intersectionFound = scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance);
-
-	// If the ray doesn't intersect, simply return (0, 0, 0).
-	if (!intersectionFound) {
-		return glm::vec3(0);
-	}
-
-	// Calculate intersection point.
-	const glm::vec3 intersectionPoint = ray.from + ray.direction * intersectionDistance;
-
-	// Retrieve primitive information for the intersected object. 
-	auto & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
-	const auto & intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-
-	// Calculate hit normal.
-	const glm::vec3 hitNormal = intersectionPrimitive->GetNormal(intersectionPoint);
-	if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON) {
-		return glm::vec3(0); // Back face culling.
-	}
-
-	// Retrieve the intersected surface's material.
-	const Material * const hitMaterial = intersectionRenderGroup.material;
-
-	// -------------------------------
-	// Emissive lighting.
-	// -------------------------------
-	if (hitMaterial->IsEmissive()) {
-		float f = 1.0f;
-		if (DEPTH >= 1) {
-			f *= glm::dot(-ray.direction, hitNormal);
-		}
-		auto self = hitMaterial->CalculateDiffuseLighting(-hitNormal, -ray.direction, hitNormal, hitMaterial->GetEmissionColor());
-		return f * hitMaterial->GetEmissionColor() + self;
-	}
-
-	// Initialize color accumulator.
-	glm::vec3 colorAccumulator = glm::vec3(0);
-	const float rf = 1.0f - hitMaterial->reflectivity;
-	const float tf = 1.0f - hitMaterial->transparency;
-
-	// -------------------------------
-	// Direct lighting.
-	// -------------------------------
-	if (rf > FLT_EPSILON && tf > FLT_EPSILON) {
-		bool shootShadowRay = true;
-#if __USE_GLOBAL_PHOTON_MAP
-		// If there are no direct light photons then approximate direct light to 0.
-		std::vector<PhotonMap::KDTreeNode> directNodesWithinRadius;
-		photonMap->GetDirectPhotonsAtPositionWithinRadius(intersectionPoint, PHOTON_SEARCH_RADIUS, directNodesWithinRadius);
-		std::vector<PhotonMap::KDTreeNode> shadowNodesWithinRadius;
-		photonMap->GetShadowPhotonsAtPositionWithinRadius(intersectionPoint, PHOTON_SEARCH_RADIUS, shadowNodesWithinRadius);
-
-		// Decide whether we need to shoot a shadow ray or not by looking in the general photon map.
-		const unsigned int dn = directNodesWithinRadius.size();
-		const unsigned int sn = shadowNodesWithinRadius.size();
-		const unsigned int sum = dn + sn;
-
-		// TODO: Move these constants to the header file.
-		const unsigned int sumLimit = 50;
-		const float upperLimit = 1200.0f;
-		const float lowerLimit = 0.0008f;
-
-		if (dn != 0 && sn != 0) {
-			float factor = sn / (float)dn;
-			if (factor < upperLimit && factor > lowerLimit) {
-				shootShadowRay = true;
-			}
-			else {
-				shootShadowRay = false;
-				for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
-					int primIdx = rand() % lightSource->primitives.size();
-					const glm::vec3 randomLightSurfacePosition = lightSource->primitives[primIdx]->GetRandomPositionOnSurface();
-					glm::vec3 directionToLight = glm::normalize(randomLightSurfacePosition - intersectionPoint);
-					const glm::vec3 lightNormal = lightSource->primitives[primIdx]->GetNormal(randomLightSurfacePosition);
-					float lightFactor = glm::dot(-directionToLight, lightNormal);
-					if (lightFactor < FLT_EPSILON) {
-						continue;
-					}
-					const glm::vec3 radiance = lightFactor * lightSource->material->GetEmissionColor();
-					colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-directionToLight, -ray.direction, hitNormal, radiance);
-				}
-			}
-		}
-		else {
-			if (sum < sumLimit) {
-				shootShadowRay = true;
-			}
-			else {
-				shootShadowRay = false;
-				if (directNodesWithinRadius.size() == 0) {
-					// Do nothing.
-				}
-				else if (shadowNodesWithinRadius.size() == 0) {
-					for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
-						int primIdx = rand() % lightSource->primitives.size();
-						const glm::vec3 randomLightSurfacePosition = lightSource->primitives[primIdx]->GetRandomPositionOnSurface();
-						glm::vec3 directionToLight = glm::normalize(randomLightSurfacePosition - intersectionPoint);
-						const glm::vec3 lightNormal = lightSource->primitives[primIdx]->GetNormal(randomLightSurfacePosition);
-						float lightFactor = glm::dot(-directionToLight, lightNormal);
-						if (lightFactor < FLT_EPSILON) {
-							continue;
-						}
-						const glm::vec3 radiance = lightFactor * lightSource->material->GetEmissionColor();
-						colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-directionToLight, -ray.direction, hitNormal, radiance);
-					}
-				}
-			}
-		}
-#endif
-		if (shootShadowRay) {
-			for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
-
-				// Create a shadow ray.
-				const glm::vec3 randomLightSurfacePosition = lightSource->GetRandomPositionOnSurface();
-				const glm::vec3 shadowRayDirection = glm::normalize(randomLightSurfacePosition - intersectionPoint);
-				if (glm::dot(shadowRayDirection, hitNormal) < FLT_EPSILON) {
-					continue;
-				}
-				const Ray shadowRay(intersectionPoint + hitNormal * 0.0001f, shadowRayDirection);
-
-				// Cast the shadow ray towards the light source.
-				unsigned int shadowRayGroupIndex, shadowRayPrimitiveIndex;
-				if (scene.RayCast(shadowRay, shadowRayGroupIndex, shadowRayPrimitiveIndex, intersectionDistance)) {
-					const auto & renderGroup = scene.renderGroups[shadowRayGroupIndex];
-					if (&renderGroup == lightSource) {
-
-						// We hit the light. Add it's contribution to the color accumulator.
-						const Primitive * lightPrimitive = renderGroup.primitives[shadowRayPrimitiveIndex];
-						const glm::vec3 lightNormal = lightPrimitive->GetNormal(shadowRay.from + intersectionDistance * shadowRay.direction);
-						float lightFactor = glm::dot(-shadowRay.direction, lightNormal);
-						if (lightFactor < FLT_EPSILON) {
-							continue;
-						}
-
-						// Direct diffuse lighting.
-						const glm::vec3 radiance = lightFactor * lightSource->material->GetEmissionColor();
-						colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
-
-#if __USE_SPECULAR_LIGHTING
-						// Specular lighting.
-						if (hitMaterial->IsSpecular()) {
-							glm::vec3 v = hitMaterial->CalculateSpecularLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
-							colorAccumulator += hitMaterial->CalculateSpecularLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
-						}
-#endif
-					}
-				}
-			}
-		}
-	}
-
-	colorAccumulator *= (1.0f / glm::max<float>(1.0f, (float)scene.emissiveRenderGroups.size()));
-
-#if	__USE_CAUSTICS_PHOTON_MAP
-	// -------------------------------
-	// Caustics photons.
-	// -------------------------------
-	std::vector<PhotonMap::KDTreeNode> causticsNodes;
-	glm::vec3 photonColorAccumulator(0);
-	glm::vec3 causticsColorAccumulator(0);
-	photonMap->GetCausticsPhotonsAtPositionWithinRadius(intersectionPoint, CAUSTICS_PHOTON_SEARCH_RADIUS, causticsNodes);
-	int currentAmountOfNodes = (int)causticsNodes.size();
-	for (int i = 0; i < currentAmountOfNodes; i++) {
-		PhotonMap::KDTreeNode node = causticsNodes[i];
-		float distance = glm::distance(intersectionPoint, node.photon.position);
-		float weight = std::max(0.0f, 1.0f - distance * WEIGHT_FACTOR);
-		auto photonNormal = node.photon.primitive->GetNormal(intersectionPoint);
-		glm::vec3 causticPhotonColor = glm::max(0.0f, glm::dot(photonNormal, hitNormal)) * weight * node.photon.color;
-		causticsColorAccumulator += hitMaterial->CalculateDiffuseLighting(node.photon.direction, ray.direction, node.photon.primitive->GetNormal(node.photon.position), causticPhotonColor);
-	}
-	if (causticsNodes.size() > 0) {
-		causticsColorAccumulator.r = std::min(1.0f, causticsColorAccumulator.r *CAUSTICS_STRENGTH_MULTIPLIER / PHOTON_SEARCH_AREA);
-		causticsColorAccumulator.g = std::min(1.0f, causticsColorAccumulator.g *CAUSTICS_STRENGTH_MULTIPLIER / PHOTON_SEARCH_AREA);
-		causticsColorAccumulator.b = std::min(1.0f, causticsColorAccumulator.b *CAUSTICS_STRENGTH_MULTIPLIER / PHOTON_SEARCH_AREA);
-		colorAccumulator += causticsColorAccumulator;
-	}
-#endif
-
-	// -------------------------------
-	// Indirect lighting.
-	// -------------------------------
-	if (rf > FLT_EPSILON && tf > FLT_EPSILON) {
-		// Shoot rays and integrate diffuse lighting based on BRDF to compute indirect lighting. 
-		const glm::vec3 reflectionDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(hitNormal);
-		assert(dot(reflectionDirection, hitNormal) > -FLT_EPSILON);
-		const Ray diffuseRay(intersectionPoint, reflectionDirection);
-		const auto incomingRadiance = TraceRay(diffuseRay, DEPTH + 1);
-		colorAccumulator += hitMaterial->CalculateDiffuseLighting(-diffuseRay.direction, -ray.direction, hitNormal, incomingRadiance);
-	}
-
-	colorAccumulator *= rf * tf;
-
-	// -------------------------------
-	// Refracted lighting.
-	// -------------------------------
-	if (hitMaterial->IsTransparent()) {
-		// Fetch refractive data.
-		const float n1 = 1.0f;
-		const float n2 = hitMaterial->refractiveIndex;
-		const float schlickConstantOutside = Utility::Rendering::CalculateSchlicksApproximation(ray.direction, hitNormal, n1, n2);
-		float schlickConstantInside = schlickConstantOutside;
-
-		// Refract ray.
-		glm::vec3 offset = hitNormal * 0.001f;
-		Ray refractedRay(intersectionPoint - offset, glm::refract(ray.direction, hitNormal, n1 / n2));
-		if (scene.RenderGroupRayCast(refractedRay, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
-			const auto & refractedRayHitPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
-			const glm::vec3 refractedIntersectionPoint = refractedRay.from + refractedRay.direction * intersectionDistance;
-			const glm::vec3 refractedHitNormal = refractedRayHitPrimitive->GetNormal(refractedIntersectionPoint);
-			schlickConstantInside = Utility::Rendering::CalculateSchlicksApproximation(refractedRay.direction, -refractedHitNormal, n2, n1);
-			Ray refractedRayOut(refractedIntersectionPoint + 0.01f * refractedHitNormal, glm::refract(refractedRay.direction, -refractedHitNormal, n2 / n1));
-			const float f1 = (1.0f - schlickConstantOutside) * (hitMaterial->transparency);
-			const float f2 = (1.0f - schlickConstantInside);
-			const auto incomingRadiance = f2 * TraceRay(refractedRayOut, DEPTH + 1);
-			colorAccumulator += f1 * hitMaterial->CalculateDiffuseLighting(refractedRay.direction, -ray.direction, hitNormal, incomingRadiance);
-		}
-		else {
-			colorAccumulator += (1.0f - schlickConstantOutside) * (hitMaterial->transparency) * TraceRay(refractedRay, DEPTH + 1);
-		}
-		Ray specularRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
-		const float sf = schlickConstantOutside * hitMaterial->specularity;
-		colorAccumulator += sf * hitMaterial->CalculateSpecularLighting(-specularRay.direction, -ray.direction, hitNormal, TraceRay(specularRay, DEPTH + 1));
-	}
-
-	// -------------------------------
-	// Reflective.
-	// -------------------------------
-	if (hitMaterial->IsReflective()) {
-		Ray reflectedRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
-		colorAccumulator += hitMaterial->reflectivity * TraceRay(reflectedRay, DEPTH + 1);
-	}
-
-	// Return result.
-	return colorAccumulator;
-}
\ No newline at end of file
+#include "PhotonMapRenderer.h"
+
+#include <algorithm>
+#include <climits>
+#include <iomanip>
+
+#include "../../Utility/Rendering.h"
+#include "../../Utility/Math.h"
+#include "../../Utility/Random.h"
+#include "../../PhotonMap/PhotonGuidingDistribution.h"
+#include "../RenderingConstants.h"
+
+#define __USE_SPECULAR_LIGHTING false
+#define __USE_CAUSTICS_PHOTON_MAP true
+#define __USE_GLOBAL_PHOTON_MAP true
+#define __USE_PRECOMPUTED_IRRADIANCE true // Use the irradiance precomputed at the photons for secondary diffuse hits.
+#define __USE_PHOTON_GUIDING false // Sample the indirect bounces from the incoming directions of nearby photons (and the cosine lobe).
+#define __USE_IRRADIANCE_CACHE true // Interpolate the indirect lighting of primary hits from cached final gathers.
+
+glm::vec3 PhotonMapRenderer::GetPixelColor(const Ray & ray, Sampler & sampler) {
+	return TraceRay(ray, sampler);
+}
+
+bool PhotonMapRenderer::TracesPackets() const {
+	return true;
+}
+
+glm::vec3 PhotonMapRenderer::TraceCameraRay(const Ray & ray, Sampler & sampler, const Intersection & intersection) {
+	return TraceRay(ray, sampler, 0, &intersection);
+}
+
+PhotonMapRenderer::PhotonMapRenderer(Scene & _scene, const unsigned int _MAX_DEPTH, const unsigned int _BOUNCES_PER_HIT,
+									 const unsigned int PHOTONS_PER_LIGHT_SOURCE, const unsigned int MAX_PHOTON_DEPTH) :
+	Renderer("Photon Map Renderer", _scene), MAX_DEPTH(_MAX_DEPTH), BOUNCES_PER_HIT(_BOUNCES_PER_HIT) {
+	photonMap.reset(new PhotonMap(_scene, PHOTONS_PER_LIGHT_SOURCE, MAX_PHOTON_DEPTH, __USE_PRECOMPUTED_IRRADIANCE));
+	irradianceStrength = ComputeIrradianceStrength();
+}
+
+float PhotonMapRenderer::ComputeIrradianceStrength() const {
+	unsigned int photonCount;
+	const Photon * const photons = photonMap->GetIrradiancePhotons(photonCount);
+	if (photonCount == 0 || scene.emissiveRenderGroups.empty()) {
+		return 0.0f;
+	}
+
+	// The sampled points and the light samples are fixed, so the strength (and the image) does not change between runs.
+	Utility::RandomGenerator random;
+	const unsigned int step = std::max(1u, photonCount / IRRADIANCE_CALIBRATION_POINT_COUNT);
+	double ratioSum = 0.0;
+	unsigned int ratioCount = 0;
+	for (unsigned int i = 0; i < photonCount; i += step) {
+		const glm::vec3 position = photons[i].position;
+		const glm::vec3 normal = photons[i].GetNormal();
+		const glm::vec3 estimate = photonMap->EstimateDirectIrradiance(position, normal);
+		const float photonIrradiance = estimate.r + estimate.g + estimate.b;
+		if (photonIrradiance <= FLT_EPSILON) {
+			continue;
+		}
+
+		// The direct lighting of TraceRay, without the surface color and the rf and tf factors (the same sampling, but several shadow rays per light).
+		glm::vec3 lighting(0);
+		for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
+			for (unsigned int j = 0; j < IRRADIANCE_CALIBRATION_LIGHT_SAMPLES; ++j) {
+				const Primitive * lightPrimitive = lightSource->primitives[random.NextUInt(static_cast<uint32_t>(lightSource->primitives.size()))];
+				const glm::vec3 randomLightSurfacePosition = lightPrimitive->GetRandomPositionOnSurface(random);
+				const glm::vec3 lightNormal = lightPrimitive->GetNormal(randomLightSurfacePosition);
+				const glm::vec3 shadowRayOrigin = position + normal * __SHADOW_RAY_ORIGIN_OFFSET;
+				const float lightDistance = glm::length(randomLightSurfacePosition - shadowRayOrigin);
+				const glm::vec3 shadowRayDirection = (randomLightSurfacePosition - shadowRayOrigin) / lightDistance;
+				const float cosine = glm::dot(shadowRayDirection, normal);
+				const float lightFactor = glm::dot(-shadowRayDirection, lightNormal);
+				if (cosine < FLT_EPSILON || lightFactor < FLT_EPSILON) {
+					continue;
+				}
+				if (scene.Occluded(Ray(shadowRayOrigin, shadowRayDirection), lightDistance - __SHADOW_RAY_LIGHT_OFFSET)) {
+					continue;
+				}
+				const float sampleWeight = lightSource->GetPrimitiveSampleWeight(lightPrimitive) / IRRADIANCE_CALIBRATION_LIGHT_SAMPLES;
+				lighting += (cosine * lightFactor * sampleWeight) * lightSource->material->GetEmissionColor();
+			}
+		}
+		lighting /= static_cast<float>(scene.emissiveRenderGroups.size());
+
+		// The photons (and so the sampled points) are denser where the irradiance is higher. Averaging the ratios, rather
+		// than dividing the sums, weights every point by the inverse of that density, i.e. it averages over the surface area.
+		ratioSum += (lighting.r + lighting.g + lighting.b) / photonIrradiance;
+		++ratioCount;
+	}
+	return ratioCount > 0 ? static_cast<float>(ratioSum / ratioCount) : 0.0f;
+}
+
+glm::vec3 PhotonMapRenderer::TraceRay(const Ray & _ray, Sampler & sampler, const unsigned int DEPTH, const Intersection * const intersection) {
+	if (DEPTH == MAX_DEPTH) {
+		return glm::vec3(0);
+	}
+
+	// Nudge the ray a little bit. 
+	// This is not really required, but it removes some unnecessary "misses" (due to floating point errors).
+	Ray ray(_ray.from + __RAY_NUDGE_DISTANCE * _ray.direction, _ray.direction);
+
+	assert(DEPTH >= 0 && DEPTH < MAX_DEPTH);
+	assert(glm::length(ray.direction) > 1.0f - 10.0f * FLT_EPSILON && glm::length(ray.direction) < 1.0f + 10.0f * FLT_EPSILON);
+
+	// See if our current ray hits anything in the scene.
+	float intersectionDistance;
+	unsigned int intersectionPrimitiveIndex, intersectionRenderGroupIndex;
+	bool intersectionFound;
+	if (intersection != nullptr) {
+		intersectionRenderGroupIndex = intersection->renderGroupIndex;
+		intersectionPrimitiveIndex = intersection->primitiveIndex;
+		intersectionDistance = intersection->distance;
+		intersectionFound = intersectionDistance != FLT_MAX;
+	}
+	else {
+		intersectionFound = scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance);
+	}
+
+	// If the ray doesn't intersect, simply return (0, 0, 0).
+	if (!intersectionFound) {
+		return glm::vec3(0);
+	}
+
+	// Calculate intersection point.
+	const glm::vec3 intersectionPoint = ray.from + ray.direction * intersectionDistance;
+
+	// Retrieve primitive information for the intersected object. 
+	auto & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+	const auto & intersectionPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+
+	// Calculate hit normal.
+	const glm::vec3 hitNormal = intersectionPrimitive->GetNormal(intersectionPoint);
+	if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON) {
+		return glm::vec3(0); // Back face culling.
+	}
+
+	// Retrieve the intersected surface's material.
+	const Material * const hitMaterial = intersectionRenderGroup.material;
+
+	// -------------------------------
+	// Emissive lighting.
+	// -------------------------------
+	if (hitMaterial->IsEmissive()) {
+		float f = 1.0f;
+		if (DEPTH >= 1) {
+			f *= glm::dot(-ray.direction, hitNormal);
+		}
+		auto self = hitMaterial->CalculateDiffuseLighting(-hitNormal, -ray.direction, hitNormal, hitMaterial->GetEmissionColor());
+		return f * hitMaterial->GetEmissionColor() + self;
+	}
+
+	// Initialize color accumulator.
+	glm::vec3 colorAccumulator = glm::vec3(0);
+	const float rf = 1.0f - hitMaterial->reflectivity;
+	const float tf = 1.0f - hitMaterial->transparency;
+
+	// -------------------------------
+	// Precomputed irradiance.
+	// -------------------------------
+	// The diffuse lighting of secondary hits is looked up at the nearest irradiance photon, instead of
+	// using shadow rays and a recursive diffuse bounce (the irradiance includes both direct and indirect light).
+	bool usePrecomputedIrradiance = false;
+	glm::vec3 precomputedIrradiance;
+#if __USE_PRECOMPUTED_IRRADIANCE
+	if (DEPTH >= 1 && rf > FLT_EPSILON && tf > FLT_EPSILON) {
+		usePrecomputedIrradiance = photonMap->GetIrradianceAtPosition(intersectionPoint, hitNormal, IRRADIANCE_LOOKUP_RADIUS, precomputedIrradiance);
+	}
+#endif
+
+	// -------------------------------
+	// Direct lighting.
+	// -------------------------------
+	if (!usePrecomputedIrradiance && rf > FLT_EPSILON && tf > FLT_EPSILON) {
+		bool shootShadowRay = true;
+#if __USE_GLOBAL_PHOTON_MAP
+		// TODO: Move these constants to the header file.
+		const unsigned int sumLimit = 50;
+		const float upperLimit = 1200.0f;
+		const float lowerLimit = 0.0008f;
+
+		// Decide whether we need to shoot a shadow ray or not by looking in the general photon map.
+		// If there are no direct light photons then approximate direct light to 0.
+		// Only the photon counts are needed. The direct photons are only counted as far as they can change the decision:
+		// up to the sum limit if there are no shadow photons, and up to the lower ratio limit otherwise.
+		const unsigned int sn = photonMap->CountShadowPhotonsAtPositionWithinRadius(intersectionPoint, PHOTON_SEARCH_RADIUS);
+		const unsigned int maxDirectCount = sn == 0 ? sumLimit : static_cast<unsigned int>(std::min(sn / (double)lowerLimit + 1.0, (double)UINT_MAX));
+		const unsigned int dn = photonMap->CountDirectPhotonsAtPositionWithinRadius(intersectionPoint, PHOTON_SEARCH_RADIUS, maxDirectCount);
+		const unsigned int sum = dn + sn;
+
+		if (dn != 0 && sn != 0) {
+			float factor = sn / (float)dn;
+			if (factor < upperLimit && factor > lowerLimit) {
+				shootShadowRay = true;
+			}
+			else {
+				shootShadowRay = false;
+				for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
+					int primIdx = sampler.GetIndex(static_cast<unsigned int>(lightSource->primitives.size()));
+					const glm::vec3 randomLightSurfacePosition = lightSource->primitives[primIdx]->GetPositionOnSurface(sampler.Get2D());
+					glm::vec3 directionToLight = glm::normalize(randomLightSurfacePosition - intersectionPoint);
+					const glm::vec3 lightNormal = lightSource->primitives[primIdx]->GetNormal(randomLightSurfacePosition);
+					float lightFactor = glm::dot(-directionToLight, lightNormal);
+					if (lightFactor < FLT_EPSILON) {
+						continue;
+					}
+					const glm::vec3 radiance = lightFactor * lightSource->GetPrimitiveSampleWeight(lightSource->primitives[primIdx]) * lightSource->material->GetEmissionColor();
+					colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-directionToLight, -ray.direction, hitNormal, radiance);
+				}
+			}
+		}
+		else {
+			if (sum < sumLimit) {
+				shootShadowRay = true;
+			}
+			else {
+				shootShadowRay = false;
+				if (dn == 0) {
+					// Do nothing.
+				}
+				else if (sn == 0) {
+					for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
+						int primIdx = sampler.GetIndex(static_cast<unsigned int>(lightSource->primitives.size()));
+						const glm::vec3 randomLightSurfacePosition = lightSource->primitives[primIdx]->GetPositionOnSurface(sampler.Get2D());
+						glm::vec3 directionToLight = glm::normalize(randomLightSurfacePosition - intersectionPoint);
+						const glm::vec3 lightNormal = lightSource->primitives[primIdx]->GetNormal(randomLightSurfacePosition);
+						float lightFactor = glm::dot(-directionToLight, lightNormal);
+						if (lightFactor < FLT_EPSILON) {
+							continue;
+						}
+						const glm::vec3 radiance = lightFactor * lightSource->GetPrimitiveSampleWeight(lightSource->primitives[primIdx]) * lightSource->material->GetEmissionColor();
+						colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-directionToLight, -ray.direction, hitNormal, radiance);
+					}
+				}
+			}
+		}
+#endif
+		if (shootShadowRay) {
+			for (RenderGroup * lightSource : scene.emissiveRenderGroups) {
+
+				// Sample a point on the light source (weighted to be uniform by area).
+				const Primitive * lightPrimitive = lightSource->primitives[sampler.GetIndex(static_cast<unsigned int>(lightSource->primitives.size()))];
+				const glm::vec3 randomLightSurfacePosition = lightPrimitive->GetPositionOnSurface(sampler.Get2D());
+				const glm::vec3 lightNormal = lightPrimitive->GetNormal(randomLightSurfacePosition);
+				const glm::vec3 shadowRayOrigin = intersectionPoint + hitNormal * __SHADOW_RAY_ORIGIN_OFFSET;
+				const float lightDistance = glm::length(randomLightSurfacePosition - shadowRayOrigin);
+				const glm::vec3 shadowRayDirection = (randomLightSurfacePosition - shadowRayOrigin) / lightDistance;
+				if (glm::dot(shadowRayDirection, hitNormal) < FLT_EPSILON) {
+					continue;
+				}
+				float lightFactor = glm::dot(-shadowRayDirection, lightNormal);
+				if (lightFactor < FLT_EPSILON) {
+					continue;
+				}
+
+				// Cast the shadow ray towards the light source. Only blockers in front of the light point matter.
+				const Ray shadowRay(shadowRayOrigin, shadowRayDirection);
+				if (scene.Occluded(shadowRay, lightDistance - __SHADOW_RAY_LIGHT_OFFSET)) {
+					continue;
+				}
+
+				// The light is visible. Add it's contribution to the color accumulator.
+				const glm::vec3 radiance = lightFactor * lightSource->GetPrimitiveSampleWeight(lightPrimitive) * lightSource->material->GetEmissionColor();
+				colorAccumulator += rf * tf * hitMaterial->CalculateDiffuseLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
+
+#if __USE_SPECULAR_LIGHTING
+				// Specular lighting.
+				if (hitMaterial->IsSpecular()) {
+					colorAccumulator += hitMaterial->CalculateSpecularLighting(-shadowRay.direction, -ray.direction, hitNormal, radiance);
+				}
+#endif
+			}
+		}
+	}
+
+	colorAccumulator *= (1.0f / glm::max<float>(1.0f, (float)scene.emissiveRenderGroups.size()));
+
+#if	__USE_CAUSTICS_PHOTON_MAP
+	// -------------------------------
+	// Caustics photons.
+	// -------------------------------
+	// The radiance is estimated from the nearest photons, using the radius of the sphere which holds them
+	// (or the search radius if there are fewer photons within it).
+	NearestPhotons causticsPhotons;
+	glm::vec3 causticsColorAccumulator(0);
+	photonMap->GetNearestCausticsPhotonsAtPosition(intersectionPoint, CAUSTICS_PHOTON_GATHER_COUNT, causticsPhotons, CAUSTICS_PHOTON_SEARCH_RADIUS);
+	const float gatherRadiusSquared = std::max(causticsPhotons.radiusSquared, __MIN_DENSITY_ESTIMATE_RADIUS * __MIN_DENSITY_ESTIMATE_RADIUS);
+	const float gatherArea = glm::pi<float>() * gatherRadiusSquared;
+	const float weightFactor = 1.0f / (WEIGHT_MODIFIER * std::sqrt(gatherRadiusSquared));
+	for (unsigned int i = 0; i < causticsPhotons.count; i++) {
+		const Photon & photon = *causticsPhotons.entries[i].photon;
+		float distance = std::sqrt(causticsPhotons.entries[i].distanceSquared);
+		float weight = std::max(0.0f, 1.0f - distance * weightFactor);
+		const glm::vec3 photonNormal = photon.GetNormal();
+		glm::vec3 causticPhotonColor = glm::max(0.0f, glm::dot(photonNormal, hitNormal)) * weight * photon.GetColor();
+		causticsColorAccumulator += hitMaterial->CalculateDiffuseLighting(photon.GetDirection(), ray.direction, photonNormal, causticPhotonColor);
+	}
+	if (causticsPhotons.count > 0) {
+		causticsColorAccumulator.r = std::min(1.0f, causticsColorAccumulator.r *CAUSTICS_STRENGTH_MULTIPLIER / gatherArea);
+		causticsColorAccumulator.g = std::min(1.0f, causticsColorAccumulator.g *CAUSTICS_STRENGTH_MULTIPLIER / gatherArea);
+		causticsColorAccumulator.b = std::min(1.0f, causticsColorAccumulator.b *CAUSTICS_STRENGTH_MULTIPLIER / gatherArea);
+		colorAccumulator += causticsColorAccumulator;
+	}
+#endif
+
+	// -------------------------------
+	// Indirect lighting.
+	// -------------------------------
+	if (usePrecomputedIrradiance) {
+		const glm::vec3 irradiance = irradianceStrength * precomputedIrradiance;
+		colorAccumulator += hitMaterial->CalculateDiffuseLighting(-hitNormal, -ray.direction, hitNormal, irradiance);
+	}
+	else if (__USE_IRRADIANCE_CACHE && DEPTH == 0 && rf > FLT_EPSILON && tf > FLT_EPSILON) {
+		// Interpolate the indirect lighting from the irradiance cache. If no cached final gather is close enough, do one here.
+		// The cache is only filled in the prepasses, so that the image does not depend on the order of the rendering threads.
+		glm::vec3 irradiance;
+		if (!irradianceCache.Interpolate(intersectionPoint, hitNormal, irradiance)) {
+			irradiance = FinalGather(intersectionPoint, hitNormal, sampler, DEPTH).irradiance;
+		}
+		colorAccumulator += hitMaterial->CalculateDiffuseLighting(-hitNormal, -ray.direction, hitNormal, irradiance);
+	}
+	else if (rf > FLT_EPSILON && tf > FLT_EPSILON) {
+		// Shoot rays and integrate diffuse lighting based on BRDF to compute indirect lighting. 
+		// With photon guiding, the weight corrects for sampling the directions where photons arrived more often.
+		glm::vec3 reflectionDirection;
+		float guidingWeight = 1.0f;
+#if __USE_PHOTON_GUIDING
+		const PhotonGuidingDistribution guidingDistribution(*photonMap, intersectionPoint, hitNormal, GUIDING_PHOTON_COUNT, GUIDING_PHOTON_RADIUS);
+		const float choice = sampler.Get1D();
+		reflectionDirection = guidingDistribution.Sample(choice, sampler.Get2D(), guidingWeight);
+#else
+		reflectionDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(hitNormal, sampler.Get2D());
+#endif
+		assert(dot(reflectionDirection, hitNormal) > -FLT_EPSILON);
+		const Ray diffuseRay(intersectionPoint, reflectionDirection);
+		const auto incomingRadiance = TraceRay(diffuseRay, sampler, DEPTH + 1);
+		colorAccumulator += guidingWeight * hitMaterial->CalculateDiffuseLighting(-diffuseRay.direction, -ray.direction, hitNormal, incomingRadiance);
+	}
+
+	colorAccumulator *= rf * tf;
+
+	// -------------------------------
+	// Refracted lighting.
+	// -------------------------------
+	if (hitMaterial->IsTransparent()) {
+		// Fetch refractive data.
+		const float n1 = 1.0f;
+		const float n2 = hitMaterial->refractiveIndex;
+		const float schlickConstantOutside = Utility::Rendering::CalculateSchlicksApproximation(ray.direction, hitNormal, n1, n2);
+		float schlickConstantInside = schlickConstantOutside;
+
+		// Refract ray.
+		glm::vec3 offset = hitNormal * 0.001f;
+		Ray refractedRay(intersectionPoint - offset, glm::refract(ray.direction, hitNormal, n1 / n2));
+		if (scene.RenderGroupRayCast(refractedRay, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+			const auto & refractedRayHitPrimitive = intersectionRenderGroup.primitives[intersectionPrimitiveIndex];
+			const glm::vec3 refractedIntersectionPoint = refractedRay.from + refractedRay.direction * intersectionDistance;
+			const glm::vec3 refractedHitNormal = refractedRayHitPrimitive->GetNormal(refractedIntersectionPoint);
+			schlickConstantInside = Utility::Rendering::CalculateSchlicksApproximation(refractedRay.direction, -refractedHitNormal, n2, n1);
+			Ray refractedRayOut(refractedIntersectionPoint + 0.01f * refractedHitNormal, glm::refract(refractedRay.direction, -refractedHitNormal, n2 / n1));
+			const float f1 = (1.0f - schlickConstantOutside) * (hitMaterial->transparency);
+			const float f2 = (1.0f - schlickConstantInside);
+			const auto incomingRadiance = f2 * TraceRay(refractedRayOut, sampler, DEPTH + 1);
+			colorAccumulator += f1 * hitMaterial->CalculateDiffuseLighting(refractedRay.direction, -ray.direction, hitNormal, incomingRadiance);
+		}
+		else {
+			colorAccumulator += (1.0f - schlickConstantOutside) * (hitMaterial->transparency) * TraceRay(refractedRay, sampler, DEPTH + 1);
+		}
+		Ray specularRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
+		const float sf = schlickConstantOutside * hitMaterial->specularity;
+		colorAccumulator += sf * hitMaterial->CalculateSpecularLighting(-specularRay.direction, -ray.direction, hitNormal, TraceRay(specularRay, sampler, DEPTH + 1));
+	}
+
+	// -------------------------------
+	// Reflective.
+	// -------------------------------
+	if (hitMaterial->IsReflective()) {
+		Ray reflectedRay(intersectionPoint, glm::reflect(ray.direction, hitNormal));
+		colorAccumulator += hitMaterial->reflectivity * TraceRay(reflectedRay, sampler, DEPTH + 1);
+	}
+
+	// Return result.
+	return colorAccumulator;
+}
+
+IrradianceCache::Record PhotonMapRenderer::FinalGather(const glm::vec3 & position, const glm::vec3 & normal, Sampler & sampler, const unsigned int DEPTH) {
+	const unsigned int M = FINAL_GATHER_THETA_STRATA, N = FINAL_GATHER_PHI_STRATA;
+	const glm::vec3 tangent = glm::normalize(glm::cross(normal, Utility::Math::NonParallellVector(normal)));
+	const glm::vec3 bitangent = glm::cross(normal, tangent);
+	const auto planeDirection = [&](const float phi) { return std::cos(phi) * tangent + std::sin(phi) * bitangent; };
+
+	// Trace one ray in every stratum (j, k), where sin^2(theta) is split into M strata and phi into N strata.
+	// This makes the rays cosine-weighted, so the estimate is the mean of the radiances times cos(theta) (as in TraceRay).
+	std::vector<glm::vec3> radiance(M * N);
+	std::vector<float> sinTheta(M * N), distance(M * N);
+	IrradianceCache::Record record;
+	record.position = position;
+	record.normal = normal;
+	record.irradiance = glm::vec3(0);
+	float inverseDistanceSum = 0.0f;
+	for (unsigned int j = 0; j < M; ++j) {
+		for (unsigned int k = 0; k < N; ++k) {
+			const glm::vec2 u = sampler.Get2D();
+			const float sinThetaSquared = (j + u.x) / M;
+			const float cosTheta = std::sqrt(1.0f - sinThetaSquared);
+			const float phi = glm::two_pi<float>() * (k + u.y) / N;
+			const unsigned int i = j * N + k;
+			sinTheta[i] = std::sqrt(sinThetaSquared);
+			const glm::vec3 direction = glm::normalize(sinTheta[i] * planeDirection(phi) + cosTheta * normal);
+
+			// The distance to the hit surface is needed, so cast the ray here and pass the intersection on.
+			Intersection intersection;
+			const Ray gatherRay(position, direction);
+			const Ray nudgedRay(position + __RAY_NUDGE_DISTANCE * direction, direction);
+			if (!scene.RayCast(nudgedRay, intersection.renderGroupIndex, intersection.primitiveIndex, intersection.distance)) {
+				intersection.distance = FLT_MAX;
+			}
+			radiance[i] = cosTheta * TraceRay(gatherRay, sampler, DEPTH + 1, &intersection);
+			distance[i] = intersection.distance;
+			record.irradiance += radiance[i];
+			inverseDistanceSum += 1.0f / intersection.distance;
+		}
+	}
+	record.irradiance /= static_cast<float>(M * N);
+	record.radius = inverseDistanceSum > 0.0f ? (M * N) / inverseDistanceSum : FLT_MAX;
+
+	// The gradients (Ward and Heckbert, "Irradiance Gradients", 1992), using the cosine weighted radiances.
+	// The rotational gradient follows from the change of the cosine of every ray when the normal is rotated,
+	// and the translational gradient from how the boundaries between the strata move over the surfaces they see.
+	for (unsigned int c = 0; c < 3; ++c) {
+		record.rotationalGradient[c] = record.translationalGradient[c] = glm::vec3(0);
+	}
+	for (unsigned int k = 0; k < N; ++k) {
+		const glm::vec3 uk = planeDirection(glm::two_pi<float>() * (k + 0.5f) / N);
+		const glm::vec3 vk = planeDirection(glm::two_pi<float>() * (k + 0.5f) / N + glm::half_pi<float>());
+		const glm::vec3 vkMin = planeDirection(glm::two_pi<float>() * k / N + glm::half_pi<float>());
+		const unsigned int previousK = (k + N - 1) % N;
+		for (unsigned int j = 0; j < M; ++j) {
+			const unsigned int i = j * N + k;
+			const float sinThetaSquaredMin = j / (float)M;
+			const float cosThetaMin = std::sqrt(1.0f - sinThetaSquaredMin);
+			const float cosThetaMax = std::sqrt(1.0f - (j + 1) / (float)M);
+
+			// Rotation: -tan(theta) times the weighted radiance.
+			const glm::vec3 rotational = -sinTheta[i] / std::max(std::sqrt(1.0f - sinTheta[i] * sinTheta[i]), FLT_EPSILON) * radiance[i];
+
+			// Translation: across the boundary to the previous polar stratum, and to the previous azimuthal stratum.
+			glm::vec3 polar(0);
+			if (j > 0) {
+				const unsigned int previousJ = i - N;
+				polar = (glm::two_pi<float>() / N) * std::sqrt(sinThetaSquaredMin) * (1.0f - sinThetaSquaredMin) /
+					std::min(distance[i], distance[previousJ]) * (radiance[i] - radiance[previousJ]);
+			}
+			const unsigned int previousI = j * N + previousK;
+			const glm::vec3 azimuthal = (cosThetaMin - cosThetaMax) / (std::sqrt((j + 0.5f) / M) * std::min(distance[i], distance[previousI])) *
+				(radiance[i] - radiance[previousI]);
+
+			for (unsigned int c = 0; c < 3; ++c) {
+				record.rotationalGradient[c] += rotational[c] / (M * N) * vk;
+				record.translationalGradient[c] += (polar[c] * uk + azimuthal[c] * vkMin) / glm::pi<float>();
+			}
+		}
+	}
+	return record;
+}
+
+unsigned int PhotonMapRenderer::GetPrepassCount() const {
+	return __USE_IRRADIANCE_CACHE ? IRRADIANCE_CACHE_PREPASS_COUNT : 0;
+}
+
+void PhotonMapRenderer::BeginPrepasses(const unsigned int _width, const unsigned int _height) {
+	width = _width;
+	height = _height;
+	prepassRecords.resize(width * height);
+	hasPrepassRecord.assign(width * height, 0);
+}
+
+void PhotonMapRenderer::TracePrepassRay(const Ray & _ray, Sampler & sampler, const unsigned int x, const unsigned int y, const unsigned int prepass) {
+	// Every prepass halves the spacing of the traced pixels.
+	const unsigned int spacing = 1u << (IRRADIANCE_CACHE_PREPASS_COUNT - 1 - prepass);
+	if (x % spacing != 0 || y % spacing != 0) {
+		return;
+	}
+
+	// Find the primary hit, and skip it if TraceRay would not use the cache there.
+	const Ray ray(_ray.from + __RAY_NUDGE_DISTANCE * _ray.direction, _ray.direction);
+	float intersectionDistance;
+	unsigned int intersectionPrimitiveIndex, intersectionRenderGroupIndex;
+	if (!scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+		return;
+	}
+	const glm::vec3 intersectionPoint = ray.from + ray.direction * intersectionDistance;
+	const auto & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+	const glm::vec3 hitNormal = intersectionRenderGroup.primitives[intersectionPrimitiveIndex]->GetNormal(intersectionPoint);
+	const Material * const hitMaterial = intersectionRenderGroup.material;
+	if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON || hitMaterial->IsEmissive() ||
+		1.0f - hitMaterial->reflectivity <= FLT_EPSILON || 1.0f - hitMaterial->transparency <= FLT_EPSILON) {
+		return;
+	}
+
+	// The cache only changes between prepasses, so whether the pixel misses it does not depend on the other threads.
+	glm::vec3 irradiance;
+	if (!irradianceCache.Interpolate(intersectionPoint, hitNormal, irradiance)) {
+		prepassRecords[x * height + y] = FinalGather(intersectionPoint, hitNormal, sampler, 0);
+		hasPrepassRecord[x * height + y] = 1;
+	}
+}
+
+void PhotonMapRenderer::EndPrepass(const unsigned int prepass) {
+	for (size_t i = 0; i < prepassRecords.size(); ++i) {
+		if (hasPrepassRecord[i]) {
+			irradianceCache.Add(prepassRecords[i]);
+			hasPrepassRecord[i] = 0;
+		}
+	}
+	if (prepass + 1 == IRRADIANCE_CACHE_PREPASS_COUNT) {
+		prepassRecords = std::vector<IrradianceCache::Record>();
+		hasPrepassRecord = std::vector<unsigned char>();
+	}
+}
+
+void PhotonMapRenderer::WriteStatistics(std::ostream & out, const unsigned int COL_WIDTH) const {
+	const uint64_t lookups = irradianceCache.GetLookupCount();
+	const double hitRate = lookups > 0 ? irradianceCache.GetHitCount() / (double)lookups : 0.0;
+	out << std::setw(COL_WIDTH) << std::left << "Irradiance strength:" << irradianceStrength << std::endl;
+	out << std::setw(COL_WIDTH) << std::left << "Irradiance cache records:" << irradianceCache.Size() << std::endl;
+	out << std::setw(COL_WIDTH) << std::left << "Irradiance cache hit rate:" << 100.0 * hitRate << " %" << std::endl;
+}
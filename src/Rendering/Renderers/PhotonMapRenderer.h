@@ -1,23 +1,73 @@
-#pragma once
-
-#include "Renderer.h"
-#include "../../Scene/Scene.h"
-
-class PhotonMapRenderer : public Renderer {
-public:
-	PhotonMapRenderer(Scene & scene, const unsigned int MAX_DEPTH = 5, const unsigned int BOUNCES_PER_HIT = 1,
-					  const unsigned int PHOTONS_PER_LIGHT_SOURCE = 1000000, const unsigned int MAX_PHOTON_DEPTH = 3);
-	glm::vec3 GetPixelColor(const Ray & ray) override;
-private:
-	const unsigned int MAX_DEPTH, BOUNCES_PER_HIT;
-	const float PHOTON_SEARCH_RADIUS = 0.5f;
-	const float CAUSTICS_PHOTON_SEARCH_RADIUS = 0.05f;
-	const float PHOTON_SEARCH_AREA = glm::pi<float>() * CAUSTICS_PHOTON_SEARCH_RADIUS * CAUSTICS_PHOTON_SEARCH_RADIUS;
-	const float WEIGHT_MODIFIER = 1.0f;
-	const float WEIGHT_FACTOR = 1.0f / (WEIGHT_MODIFIER * CAUSTICS_PHOTON_SEARCH_RADIUS);
-	const float CAUSTICS_STRENGTH_MULTIPLIER = 10.0;
-	PhotonMap* photonMap;
-
-	/// <summary> Traces a ray through the scene. </summary>
-	glm::vec3 TraceRay(const Ray & ray, const unsigned int DEPTH = 0);
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Renderer.h"
+#include "../IrradianceCache.h"
+#include "../../Scene/Scene.h"
+
+class PhotonMapRenderer : public Renderer {
+public:
+	PhotonMapRenderer(Scene & scene, const unsigned int MAX_DEPTH = 5, const unsigned int BOUNCES_PER_HIT = 1,
+					  const unsigned int PHOTONS_PER_LIGHT_SOURCE = 1000000, const unsigned int MAX_PHOTON_DEPTH = 3);
+	glm::vec3 GetPixelColor(const Ray & ray, Sampler & sampler) override;
+	bool TracesPackets() const override;
+	glm::vec3 TraceCameraRay(const Ray & ray, Sampler & sampler, const Intersection & intersection) override;
+	void WriteStatistics(std::ostream & out, const unsigned int COL_WIDTH) const override;
+
+	/// <summary>
+	/// The irradiance cache is filled in prepasses over ever finer grids of pixels. Every prepass looks up the records
+	/// of the earlier prepasses, and its new records are added in pixel order once it is finished. The image is then
+	/// rendered with the finished cache, so it does not depend on the number of threads or on their scheduling.
+	/// </summary>
+	unsigned int GetPrepassCount() const override;
+	void BeginPrepasses(const unsigned int width, const unsigned int height) override;
+	void TracePrepassRay(const Ray & ray, Sampler & sampler, const unsigned int x, const unsigned int y, const unsigned int prepass) override;
+	void EndPrepass(const unsigned int prepass) override;
+private:
+	const unsigned int MAX_DEPTH, BOUNCES_PER_HIT;
+	const float PHOTON_SEARCH_RADIUS = 0.5f;
+	const float CAUSTICS_PHOTON_SEARCH_RADIUS = 0.05f;
+	const unsigned int CAUSTICS_PHOTON_GATHER_COUNT = 64; // The number of caustics photons gathered at a hit.
+	const float WEIGHT_MODIFIER = 1.0f;
+	const float CAUSTICS_STRENGTH_MULTIPLIER = 10.0;
+	const unsigned int GUIDING_PHOTON_COUNT = 64; // The number of direct and of indirect photons which guide a bounce.
+	const float GUIDING_PHOTON_RADIUS = 0.5f; // The largest distance to the photons which guide a bounce.
+	const float IRRADIANCE_LOOKUP_RADIUS = 0.5f; // The largest distance to the irradiance photon used at a secondary hit.
+	const unsigned int IRRADIANCE_CALIBRATION_POINT_COUNT = 1024; // The largest number of irradiance photons used to compute the irradiance strength.
+	const unsigned int IRRADIANCE_CALIBRATION_LIGHT_SAMPLES = 16; // The number of shadow rays per light source at each of them.
+	const unsigned int FINAL_GATHER_THETA_STRATA = 6; // The final gather of an irradiance cache record traces
+	const unsigned int FINAL_GATHER_PHI_STRATA = 18; // one ray in each of these (polar x azimuthal) hemisphere strata.
+	const unsigned int IRRADIANCE_CACHE_PREPASS_COUNT = 4; // The first prepass traces every 8th pixel (in x and y), the last every pixel.
+	std::unique_ptr<const PhotonMap> photonMap;
+
+	/// <summary> Brings the photon irradiance to the scale of the shadow ray lighting of the primary hits (see ComputeIrradianceStrength). </summary>
+	float irradianceStrength;
+
+	/// <summary> The final gathers of the primary diffuse hits, shared by all rendering threads. </summary>
+	IrradianceCache irradianceCache;
+
+	/// <summary> The record of every pixel which missed the cache in the current prepass (if hasPrepassRecord is set). </summary>
+	unsigned int width = 0, height = 0;
+	std::vector<IrradianceCache::Record> prepassRecords;
+	std::vector<unsigned char> hasPrepassRecord;
+
+	/// <summary>
+	/// Computes the irradiance strength of this scene. The shadow ray lighting has no distance falloff, so it has no fixed
+	/// scale relative to the photons. Instead, the direct lighting is computed the way TraceRay does it at a subset of the
+	/// irradiance photons, and compared to the irradiance estimated from the direct photons at the same points.
+	/// </summary>
+	float ComputeIrradianceStrength() const;
+
+	/// <summary> Traces a ray through the scene. </summary>
+	/// <param name='intersection'> The closest intersection of the (nudged) ray if it is already known, otherwise nullptr. </param>
+	glm::vec3 TraceRay(const Ray & ray, Sampler & sampler, const unsigned int DEPTH = 0, const Intersection * const intersection = nullptr);
+
+	/// <summary>
+	/// Estimates the incoming indirect lighting at a surface point with stratified cosine-weighted rays,
+	/// weighted as the diffuse bounce of TraceRay. Returns a new irradiance cache record holding the estimate,
+	/// the harmonic mean distance to the surfaces hit and the irradiance gradients (Ward and Heckbert).
+	/// </summary>
+	IrradianceCache::Record FinalGather(const glm::vec3 & position, const glm::vec3 & normal, Sampler & sampler, const unsigned int DEPTH);
 };
\ No newline at end of file
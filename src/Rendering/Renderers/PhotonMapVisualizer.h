@@ -1,16 +1,24 @@
-#pragma once
-
-#include "Renderer.h"
-#include "../../Scene/Scene.h"
-
-class PhotonMapVisualizer : public Renderer {
-public:
-	glm::vec3 GetPixelColor(const Ray & ray) override;
-	PhotonMapVisualizer(Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE = 1000000, const unsigned int MAX_PHOTON_DEPTH = 3);
-private:
-	const float PHOTON_SEARCH_RADIUS = 0.05f;
-	const float WEIGHT_MODIFIER = 1.3f;
-	const float WEIGHT_FACTOR = 1.0f / (WEIGHT_MODIFIER * PHOTON_SEARCH_RADIUS);
-	glm::vec3 TraceRay(const Ray & ray, const unsigned int DEPTH = 0);
-	PhotonMap * photonMap;
+#pragma once
+
+#include <memory>
+
+#include "Renderer.h"
+#include "../../Scene/Scene.h"
+
+class PhotonMapVisualizer : public Renderer {
+public:
+	glm::vec3 GetPixelColor(const Ray & ray, Sampler & sampler) override;
+	PhotonMapVisualizer(Scene & scene, const unsigned int PHOTONS_PER_LIGHT_SOURCE = 1000000, const unsigned int MAX_PHOTON_DEPTH = 3);
+private:
+	const float PHOTON_SEARCH_RADIUS = 0.05f;
+	const unsigned int PHOTON_GATHER_COUNT = 64;
+	const float WEIGHT_MODIFIER = 1.3f;
+	glm::vec3 TraceRay(const Ray & ray);
+
+	/// <summary>
+	/// Sums the cone filtered contributions of the nearest photons, scaled by their density relative to the search radius.
+	/// Photons are weighted by the given color, or by their own color if it is nullptr.
+	/// </summary>
+	glm::vec3 AccumulatePhotons(const NearestPhotons & photons, const glm::vec3 & normal, const glm::vec3 * color = nullptr) const;
+	std::unique_ptr<const PhotonMap> photonMap;
 };
\ No newline at end of file
@@ -1,18 +1,104 @@
-#pragma once
-
-#include <string>
-
-#include <glm.hpp>
-
-#include "../../Geometry/Ray.h"
-#include "../Materials/Material.h"
-#include "../../Scene/Scene.h"
-
-class Renderer {
-public:
-	virtual glm::vec3 GetPixelColor(const Ray & ray) = 0;
-	const std::string RENDERER_NAME = "Unknown Name";
-protected:
-	Renderer(const std::string NAME, Scene & _scene) : RENDERER_NAME(NAME), scene(_scene) { }
-	Scene & scene;
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <cassert>
+
+#include <glm.hpp>
+
+#include "../../Geometry/Ray.h"
+#include "../Materials/Material.h"
+#include "../../Scene/Scene.h"
+#include "../Samplers/Sampler.h"
+#include "../../Utility/ThreadPool.h"
+#include "../RenderingConstants.h"
+
+class Renderer {
+public:
+	/// <summary> 
+	/// Computes the color of a camera ray. All sample values (e.g. for choosing light positions and bounce directions)
+	/// are requested from the given sampler, which has already started the sample of the ray.
+	/// </summary>
+	virtual glm::vec3 GetPixelColor(const Ray & ray, Sampler & sampler) = 0;
+
+	/// <summary> 
+	/// Computes the colors of a packet of at most Accelerator::MAX_PACKET_SIZE coherent camera rays (see Camera::Render).
+	/// Every ray has its own sampler. If the renderer traces packets, the first hits of all rays are found at once and
+	/// passed to TraceCameraRay. Otherwise GetPixelColor is called for every ray.
+	/// </summary>
+	void GetPixelColors(const Ray rays[], const unsigned int count, glm::vec3 colors[], Sampler * const samplers[]) {
+		if (!TracesPackets()) {
+			for (unsigned int i = 0; i < count; ++i) {
+				colors[i] = GetPixelColor(rays[i], *samplers[i]);
+			}
+			return;
+		}
+
+		// Find the first hit of all camera rays at once. The remaining bounces are incoherent and are traced one ray at a time.
+		assert(count <= Accelerator::MAX_PACKET_SIZE);
+		Ray nudgedRays[Accelerator::MAX_PACKET_SIZE];
+		for (unsigned int i = 0; i < count; ++i) {
+			nudgedRays[i] = Ray(rays[i].from + __RAY_NUDGE_DISTANCE * rays[i].direction, rays[i].direction);
+		}
+		Intersection intersections[Accelerator::MAX_PACKET_SIZE];
+		scene.RayCastPacket(nudgedRays, count, intersections);
+		for (unsigned int i = 0; i < count; ++i) {
+			colors[i] = TraceCameraRay(rays[i], *samplers[i], intersections[i]);
+		}
+	}
+
+	/// <summary> Returns true if GetPixelColors should find the first hits of its camera rays at once (see TraceCameraRay). </summary>
+	virtual bool TracesPackets() const { return false; }
+
+	/// <summary> 
+	/// Computes the color of a camera ray whose first hit is already known. The intersection is the closest one of the ray
+	/// moved forward by __RAY_NUDGE_DISTANCE, as the renderers cast their rays. Only called if the renderer traces packets.
+	/// </summary>
+	virtual glm::vec3 TraceCameraRay(const Ray & ray, Sampler & sampler, const Intersection &) { return GetPixelColor(ray, sampler); }
+
+	/// <summary>
+	/// Returns the number of prepasses which the renderer needs before the image is rendered, for example to fill a cache
+	/// in an order which does not depend on the rendering threads. Camera::Render calls BeginPrepasses, then traces one camera
+	/// ray per pixel and prepass with TracePrepassRay, and calls EndPrepass after every prepass. None by default.
+	/// </summary>
+	virtual unsigned int GetPrepassCount() const { return 0; }
+
+	/// <summary> Starts the prepasses of an image with the given size. </summary>
+	virtual void BeginPrepasses(const unsigned int, const unsigned int) { }
+
+	/// <summary> Traces the camera ray of pixel (x, y) in a prepass. Called concurrently for different pixels. </summary>
+	virtual void TracePrepassRay(const Ray &, Sampler &, const unsigned int, const unsigned int, const unsigned int) { }
+
+	/// <summary> Finishes a prepass, once the camera rays of all pixels are traced. </summary>
+	virtual void EndPrepass(const unsigned int) { }
+
+	/// <summary>
+	/// Returns true if the renderer is progressive, i.e. refines all pixels together in passes (see SPPMRenderer).
+	/// Camera::Render then traces one camera ray per pixel and pass with TracePassRay (instead of calling GetPixelColors),
+	/// calls EndPass after every pass and finally reads the pixel colors with GetPassPixelColor.
+	/// </summary>
+	virtual bool IsProgressive() const { return false; }
+
+	/// <summary> Starts a progressive render of an image with the given size, in the given number of passes. </summary>
+	virtual void BeginPasses(const unsigned int, const unsigned int, const unsigned int) { }
+
+	/// <summary> Traces the camera ray of pixel (x, y) in the current pass. Called concurrently for different pixels. </summary>
+	/// <param name='weight'> The weight of the ray, which scales its contribution to the pixel. </param>
+	virtual void TracePassRay(const Ray &, const float, Sampler &, const unsigned int, const unsigned int) { }
+
+	/// <summary> Finishes the current pass, once the camera rays of all pixels are traced. </summary>
+	/// <param name='threadPool'> The rendering threads, which may be used to finish the pass. </param>
+	virtual void EndPass(Utility::ThreadPool &) { }
+
+	/// <summary> Returns the color of pixel (x, y) after all finished passes. </summary>
+	virtual glm::vec3 GetPassPixelColor(const unsigned int, const unsigned int) const { return glm::vec3(0); }
+
+	/// <summary> Writes statistics gathered while rendering (one line each, labels padded to COL_WIDTH). Writes nothing by default. </summary>
+	virtual void WriteStatistics(std::ostream &, const unsigned int) const { }
+
+	const std::string RENDERER_NAME = "Unknown Name";
+	virtual ~Renderer() { }
+protected:
+	Renderer(const std::string NAME, Scene & _scene) : RENDERER_NAME(NAME), scene(_scene) { }
+	Scene & scene;
 };
\ No newline at end of file
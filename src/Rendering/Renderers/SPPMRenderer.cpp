@@ -0,0 +1,311 @@
+#include "SPPMRenderer.h"
+
+#include <algorithm>
+
+#include "../../Utility/Rendering.h"
+#include "../../Utility/Math.h"
+#include "../../Utility/Random.h"
+#include "../RenderingConstants.h"
+
+
+SPPMRenderer::SPPMRenderer(Scene & _scene, const unsigned int _MAX_DEPTH, const unsigned int _PHOTONS_PER_PASS,
+						   const unsigned int _MAX_PHOTON_DEPTH) :
+	Renderer("Stochastic Progressive Photon Mapping Renderer", _scene),
+	MAX_DEPTH(_MAX_DEPTH), PHOTONS_PER_PASS(_PHOTONS_PER_PASS), MAX_PHOTON_DEPTH(_MAX_PHOTON_DEPTH) {
+
+	// The light sources are diffuse emitters, so their power is pi times their emitted radiance times their area.
+	for (const RenderGroup * lightSource : scene.emissiveRenderGroups) {
+		lightPowers.push_back(glm::pi<float>() * lightSource->area * lightSource->material->GetEmissionColor());
+	}
+}
+
+glm::vec3 SPPMRenderer::GetPixelColor(const Ray & ray, Sampler & sampler) {
+	VisiblePoint visiblePoint;
+	return TraceVisiblePoint(ray, glm::vec3(1.0f), sampler, visiblePoint);
+}
+
+void SPPMRenderer::BeginPasses(const unsigned int _width, const unsigned int _height, const unsigned int) {
+	width = _width;
+	height = _height;
+	passCount = 0;
+	pixels.assign(width * height, PixelStatistics());
+	for (PixelStatistics & pixel : pixels) {
+		pixel.radius = INITIAL_SEARCH_RADIUS;
+	}
+}
+
+void SPPMRenderer::TracePassRay(const Ray & ray, const float weight, Sampler & sampler, const unsigned int x, const unsigned int y) {
+	PixelStatistics & pixel = pixels[x * height + y];
+	pixel.visiblePoint.material = nullptr;
+	pixel.directLight += TraceVisiblePoint(ray, glm::vec3(weight), sampler, pixel.visiblePoint);
+}
+
+void SPPMRenderer::EndPass(Utility::ThreadPool & threadPool) {
+	// Trace the photons of this pass in batches. The batches are merged in order, which gives the same photons for any number of threads.
+	const unsigned int BATCHES_PER_LIGHT_SOURCE = (PHOTONS_PER_PASS + __PHOTON_BATCH_SIZE - 1) / __PHOTON_BATCH_SIZE;
+	const unsigned int BATCH_COUNT = static_cast<unsigned int>(scene.emissiveRenderGroups.size()) * BATCHES_PER_LIGHT_SOURCE;
+	photonBatches.resize(BATCH_COUNT);
+	threadPool.Run(BATCH_COUNT, [&](unsigned int batchIndex, unsigned int) {
+		const unsigned int first = (batchIndex % BATCHES_PER_LIGHT_SOURCE) * __PHOTON_BATCH_SIZE;
+		const unsigned int last = std::min(first + __PHOTON_BATCH_SIZE, PHOTONS_PER_PASS);
+		photonBatches[batchIndex].clear();
+		TracePhotons(batchIndex / BATCHES_PER_LIGHT_SOURCE, first, last, photonBatches[batchIndex]);
+	});
+	photons.clear();
+	for (const std::vector<Photon> & batch : photonBatches) {
+		photons.insert(photons.end(), batch.begin(), batch.end());
+	}
+	photonTree.Build(photons);
+
+	// Gather the photons at the visible points, one image column per task.
+	gatheredPhotons.resize(threadPool.GetThreadCount());
+	threadPool.Run(width, [&](unsigned int x, unsigned int thread) {
+		for (unsigned int y = 0; y < height; ++y) {
+			GatherPhotons(pixels[x * height + y], gatheredPhotons[thread]);
+		}
+	});
+	++passCount;
+}
+
+glm::vec3 SPPMRenderer::GetPassPixelColor(const unsigned int x, const unsigned int y) const {
+	if (passCount == 0) {
+		return glm::vec3(0);
+	}
+	const PixelStatistics & pixel = pixels[x * height + y];
+	const glm::vec3 indirectLight = pixel.flux / (glm::pi<float>() * pixel.radius * pixel.radius);
+	return (pixel.directLight + indirectLight) / static_cast<float>(passCount);
+}
+
+glm::vec3 SPPMRenderer::TraceVisiblePoint(const Ray & _ray, const glm::vec3 & _weight, Sampler & sampler, VisiblePoint & visiblePoint) const {
+	glm::vec3 colorAccumulator(0);
+	glm::vec3 weight = _weight;
+	Ray ray = _ray;
+	for (unsigned int depth = 0; depth < MAX_DEPTH; ++depth) {
+
+		// Nudge the ray a little bit, and find its closest intersection.
+		ray = Ray(ray.from + __RAY_NUDGE_DISTANCE * ray.direction, ray.direction);
+		float intersectionDistance;
+		unsigned int intersectionPrimitiveIndex, intersectionRenderGroupIndex;
+		if (!scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+			break;
+		}
+		const glm::vec3 intersectionPoint = ray.from + ray.direction * intersectionDistance;
+		const RenderGroup & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+		const glm::vec3 hitNormal = intersectionRenderGroup.primitives[intersectionPrimitiveIndex]->GetNormal(intersectionPoint);
+		if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON) {
+			break; // Back face culling.
+		}
+		const Material * const hitMaterial = intersectionRenderGroup.material;
+
+		// Emissive lighting.
+		if (hitMaterial->IsEmissive()) {
+			colorAccumulator += weight * hitMaterial->GetEmissionColor();
+			break;
+		}
+
+		// Direct lighting of the diffuse part of the material.
+		const float diffuseWeight = (1.0f - hitMaterial->reflectivity) * (1.0f - hitMaterial->transparency);
+		if (diffuseWeight > FLT_EPSILON) {
+			colorAccumulator += diffuseWeight * weight * SampleDirectLighting(intersectionPoint, hitNormal, -ray.direction, hitMaterial, sampler);
+		}
+
+		// Follow mirrored and refracted rays until the diffuse part of a material is chosen.
+		const glm::vec3 outDirection = -ray.direction;
+		const Scattering scattering = Scatter(ray, intersectionPoint, hitNormal, intersectionRenderGroupIndex, sampler.Get1D(), weight);
+		if (scattering == Scattering::DIFFUSE) {
+			visiblePoint.position = intersectionPoint;
+			visiblePoint.normal = hitNormal;
+			visiblePoint.outDirection = outDirection;
+			visiblePoint.weight = weight;
+			visiblePoint.material = hitMaterial;
+		}
+		if (scattering != Scattering::SPECULAR) {
+			break;
+		}
+	}
+	return colorAccumulator;
+}
+
+glm::vec3 SPPMRenderer::SampleDirectLighting(const glm::vec3 & position, const glm::vec3 & normal, const glm::vec3 & outDirection,
+											 const Material * material, Sampler & sampler) const {
+	glm::vec3 colorAccumulator(0);
+	for (const RenderGroup * lightSource : scene.emissiveRenderGroups) {
+
+		// Sample a point on a random primitive of the light source.
+		const unsigned int primitiveCount = static_cast<unsigned int>(lightSource->primitives.size());
+		const Primitive * lightPrimitive = lightSource->primitives[sampler.GetIndex(primitiveCount)];
+		const glm::vec3 lightPosition = lightPrimitive->GetPositionOnSurface(sampler.Get2D());
+		const glm::vec3 lightNormal = lightPrimitive->GetNormal(lightPosition);
+		const glm::vec3 shadowRayOrigin = position + normal * __SHADOW_RAY_ORIGIN_OFFSET;
+		const float lightDistance = glm::length(lightPosition - shadowRayOrigin);
+		const glm::vec3 shadowRayDirection = (lightPosition - shadowRayOrigin) / lightDistance;
+		if (glm::dot(shadowRayDirection, normal) < FLT_EPSILON) {
+			continue;
+		}
+		const float lightFactor = glm::dot(-shadowRayDirection, lightNormal);
+		if (lightFactor < FLT_EPSILON) {
+			continue;
+		}
+		if (scene.Occluded(Ray(shadowRayOrigin, shadowRayDirection), lightDistance - __SHADOW_RAY_LIGHT_OFFSET)) {
+			continue;
+		}
+
+		// The irradiance from the light point, divided by the probability density of choosing it (and by pi for the BRDF).
+		const float inversePdf = primitiveCount * lightPrimitive->GetArea();
+		const glm::vec3 radiance = (lightFactor * inversePdf / (glm::pi<float>() * lightDistance * lightDistance)) * lightSource->material->GetEmissionColor();
+		colorAccumulator += material->CalculateDiffuseLighting(-shadowRayDirection, outDirection, normal, radiance);
+	}
+	return colorAccumulator;
+}
+
+void SPPMRenderer::TracePhotons(const unsigned int i, const unsigned int first, const unsigned int last, std::vector<Photon> & batch) const {
+	const RenderGroup * lightSource = scene.emissiveRenderGroups[i];
+	const unsigned int primitiveCount = static_cast<unsigned int>(lightSource->primitives.size());
+	for (unsigned int j = first; j < last; ++j) {
+		// Every photon path has its own random sequence, given by its pass, light source and photon index.
+		Utility::RandomGenerator random(static_cast<uint64_t>(passCount) * PHOTONS_PER_PASS + j, i);
+
+		// Emit the photon from a random light surface position, in a cosine weighted direction. The primitive is chosen
+		// uniformly by index, so the position is only uniform by area if the primitives are equally large. The power is
+		// scaled by the primitive's area relative to the average primitive, which keeps the emission unbiased.
+		const Primitive * lightPrimitive = lightSource->primitives[random.NextUInt(primitiveCount)];
+		const glm::vec3 lightPosition = lightPrimitive->GetRandomPositionOnSurface(random);
+		const glm::vec3 lightNormal = lightPrimitive->GetNormal(lightPosition);
+		Ray ray(lightPosition + 0.01f * lightNormal, Utility::Math::CosineWeightedHemisphereSampleDirection(lightNormal, random));
+		glm::vec3 power = (lightSource->GetPrimitiveSampleWeight(lightPrimitive) / static_cast<float>(PHOTONS_PER_PASS)) * lightPowers[i];
+
+		for (unsigned int depth = 0; depth < MAX_PHOTON_DEPTH; ++depth) {
+			float intersectionDistance;
+			unsigned int intersectionRenderGroupIndex, intersectionPrimitiveIndex;
+			if (!scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance)) {
+				break;
+			}
+			const glm::vec3 intersectionPoint = ray.from + intersectionDistance * ray.direction;
+			const RenderGroup & intersectionRenderGroup = scene.renderGroups[intersectionRenderGroupIndex];
+			const glm::vec3 hitNormal = intersectionRenderGroup.primitives[intersectionPrimitiveIndex]->GetNormal(intersectionPoint);
+			const Material * const hitMaterial = intersectionRenderGroup.material;
+			if (glm::dot(-ray.direction, hitNormal) < FLT_EPSILON || hitMaterial->IsEmissive()) {
+				break;
+			}
+
+			// Store the photon if the surface is (partly) diffuse. Light directly from the light sources is sampled with shadow rays instead.
+			const float diffuseWeight = (1.0f - hitMaterial->reflectivity) * (1.0f - hitMaterial->transparency);
+			if (depth > 0 && diffuseWeight > FLT_EPSILON) {
+				batch.push_back(Photon(intersectionPoint, ray.direction, power, hitNormal));
+			}
+
+			// Continue the path, bouncing diffusely if the diffuse part of the material is chosen.
+			const glm::vec3 inDirection = ray.direction;
+			const glm::vec3 previousPower = power;
+			const Scattering scattering = Scatter(ray, intersectionPoint, hitNormal, intersectionRenderGroupIndex, random.NextFloat(), power);
+			if (scattering == Scattering::ABSORBED) {
+				break;
+			}
+			if (scattering == Scattering::DIFFUSE) {
+				const glm::vec3 reflectionDirection = Utility::Math::CosineWeightedHemisphereSampleDirection(hitNormal, random);
+				power *= Reflectance(hitMaterial, inDirection, reflectionDirection, hitNormal);
+				ray = Ray(intersectionPoint + 0.001f * hitNormal, reflectionDirection);
+			}
+
+			// Russian roulette, which keeps the power of the surviving photons (roughly) constant.
+			const float maxPower = std::max(power.r, std::max(power.g, power.b));
+			const float maxPreviousPower = std::max(previousPower.r, std::max(previousPower.g, previousPower.b));
+			const float survivalProbability = std::min(1.0f, maxPower / maxPreviousPower);
+			if (!(random.NextFloat() < survivalProbability)) {
+				break;
+			}
+			power /= survivalProbability;
+		}
+	}
+}
+
+void SPPMRenderer::GatherPhotons(PixelStatistics & pixel, std::vector<Photon> & found) const {
+	const VisiblePoint & visiblePoint = pixel.visiblePoint;
+	if (visiblePoint.material == nullptr) {
+		return;
+	}
+
+	// Sum the reflected flux of the photons within the radius.
+	found.clear();
+	photonTree.FindWithinRadius(visiblePoint.position, pixel.radius, found);
+	glm::vec3 passFlux(0);
+	unsigned int passPhotonCount = 0;
+	for (const Photon & photon : found) {
+		if (glm::dot(photon.GetNormal(), visiblePoint.normal) < __MIN_NORMAL_SIMILARITY) {
+			continue;
+		}
+		passFlux += Reflectance(visiblePoint.material, photon.GetDirection(), visiblePoint.outDirection, visiblePoint.normal) * photon.GetColor();
+		++passPhotonCount;
+	}
+	if (passPhotonCount == 0) {
+		return;
+	}
+
+	// Keep a fraction of the new photons, and shrink the radius so that the photon density is kept.
+	const float photonCount = pixel.photonCount + PHOTON_FRACTION * passPhotonCount;
+	const float radius = pixel.radius * std::sqrt(photonCount / (pixel.photonCount + passPhotonCount));
+	const float radiusReduction = (radius * radius) / (pixel.radius * pixel.radius);
+	pixel.flux = (pixel.flux + visiblePoint.weight * passFlux / glm::pi<float>()) * radiusReduction;
+	pixel.photonCount = photonCount;
+	pixel.radius = radius;
+}
+
+SPPMRenderer::Scattering SPPMRenderer::Scatter(Ray & ray, const glm::vec3 & position, const glm::vec3 & normal, const unsigned int renderGroupIndex,
+											   const float u, glm::vec3 & weight) const {
+	const Material * const material = scene.renderGroups[renderGroupIndex].material;
+	const float diffuseWeight = (1.0f - material->reflectivity) * (1.0f - material->transparency);
+	const float reflectiveWeight = material->IsReflective() ? material->reflectivity : 0.0f;
+	float refractiveWeight = 0.0f, specularWeight = 0.0f, schlickConstantOutside = 0.0f;
+	if (material->IsTransparent()) {
+		schlickConstantOutside = Utility::Rendering::CalculateSchlicksApproximation(ray.direction, normal, 1.0f, material->refractiveIndex);
+		refractiveWeight = (1.0f - schlickConstantOutside) * material->transparency;
+		specularWeight = schlickConstantOutside * material->specularity;
+	}
+	const float weightSum = (diffuseWeight > FLT_EPSILON ? diffuseWeight : 0.0f) + reflectiveWeight + refractiveWeight + specularWeight;
+	if (weightSum < FLT_EPSILON) {
+		return Scattering::ABSORBED;
+	}
+	weight *= weightSum;
+
+	// Choose the part of the material.
+	float v = u * weightSum;
+	if (diffuseWeight > FLT_EPSILON && (v -= diffuseWeight) < 0.0f) {
+		return Scattering::DIFFUSE;
+	}
+	if (refractiveWeight > 0.0f && (v -= refractiveWeight) < 0.0f) {
+		// Refract into the object, and out of it where the refracted ray leaves it.
+		const float n1 = 1.0f;
+		const float n2 = material->refractiveIndex;
+		const RenderGroup & renderGroup = scene.renderGroups[renderGroupIndex];
+		Ray refractedRay(position - normal * 0.001f, glm::refract(ray.direction, normal, n1 / n2));
+		unsigned int exitPrimitiveIndex;
+		float exitDistance;
+		if (scene.RenderGroupRayCast(refractedRay, renderGroupIndex, exitPrimitiveIndex, exitDistance)) {
+			const glm::vec3 exitPoint = refractedRay.from + refractedRay.direction * exitDistance;
+			const glm::vec3 exitNormal = renderGroup.primitives[exitPrimitiveIndex]->GetNormal(exitPoint);
+			const glm::vec3 exitDirection = glm::refract(refractedRay.direction, -exitNormal, n2 / n1);
+			if (glm::dot(exitDirection, exitDirection) < 0.5f) {
+				return Scattering::ABSORBED; // Total internal reflection.
+			}
+			weight *= 1.0f - Utility::Rendering::CalculateSchlicksApproximation(refractedRay.direction, -exitNormal, n2, n1);
+			ray = Ray(exitPoint + 0.01f * exitNormal, exitDirection);
+		}
+		else {
+			ray = refractedRay;
+		}
+		return Scattering::SPECULAR;
+	}
+
+	// Mirror reflection (of reflective materials, or of the specular part of transparent materials).
+	ray = Ray(position, glm::reflect(ray.direction, normal));
+	return Scattering::SPECULAR;
+}
+
+glm::vec3 SPPMRenderer::Reflectance(const Material * material, const glm::vec3 & inDirection, const glm::vec3 & outDirection, const glm::vec3 & normal) {
+	// CalculateDiffuseLighting includes the cosine of the incoming direction.
+	const float cosine = glm::dot(-inDirection, normal);
+	if (cosine < FLT_EPSILON) {
+		return glm::vec3(0);
+	}
+	return material->CalculateDiffuseLighting(inDirection, outDirection, normal, glm::vec3(1.0f)) / cosine;
+}
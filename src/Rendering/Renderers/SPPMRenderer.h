@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+
+#include "Renderer.h"
+#include "../../Scene/Scene.h"
+#include "../../PhotonMap/PhotonKDTree.h"
+
+/// <summary>
+/// A stochastic progressive photon mapping renderer (Hachisuka and Jensen, "Stochastic Progressive Photon Mapping", 2009).
+/// Every pass traces one camera ray per pixel through mirrors and glass to a diffuse hit (the visible point of the pixel),
+/// where direct lighting is sampled with shadow rays. Then a fixed number of photons is traced, and the photons within
+/// the search radius of every visible point are added to the flux of its pixel, while the radius shrinks.
+/// Only the photons of the current pass are stored, so the memory usage is constant and the indirect lighting
+/// and the caustics keep converging with more passes (the camera's rays per pixel).
+/// </summary>
+class SPPMRenderer : public Renderer {
+public:
+	/// <param name='MAX_DEPTH'> The number of surfaces a camera ray can hit (at most). </param>
+	/// <param name='PHOTONS_PER_PASS'> The number of photon paths traced per light source in every pass. </param>
+	/// <param name='MAX_PHOTON_DEPTH'> The number of surfaces a photon can hit (at most). </param>
+	SPPMRenderer(Scene & scene, const unsigned int MAX_DEPTH = 5, const unsigned int PHOTONS_PER_PASS = 100000,
+				 const unsigned int MAX_PHOTON_DEPTH = 4);
+
+	/// <summary> Returns the emitted and the direct lighting only, since photons are only traced between passes. </summary>
+	glm::vec3 GetPixelColor(const Ray & ray, Sampler & sampler) override;
+
+	bool IsProgressive() const override { return true; }
+	void BeginPasses(const unsigned int width, const unsigned int height, const unsigned int passCount) override;
+	void TracePassRay(const Ray & ray, const float weight, Sampler & sampler, const unsigned int x, const unsigned int y) override;
+	void EndPass(Utility::ThreadPool & threadPool) override;
+	glm::vec3 GetPassPixelColor(const unsigned int x, const unsigned int y) const override;
+private:
+	const unsigned int MAX_DEPTH, PHOTONS_PER_PASS, MAX_PHOTON_DEPTH;
+	const float INITIAL_SEARCH_RADIUS = 0.1f;
+	const float PHOTON_FRACTION = 0.7f; // The fraction of the photons of a pass which is kept by the radius reduction (alpha).
+
+	/// <summary> The first diffuse hit of a camera ray, where the photons are gathered. </summary>
+	struct VisiblePoint {
+		glm::vec3 position, normal, outDirection;
+		glm::vec3 weight; // The throughput of the camera ray, including the choice of the diffuse part of the material.
+		const Material * material = nullptr; // nullptr if the camera ray did not reach a diffuse surface.
+	};
+
+	/// <summary> The statistics of a pixel, which are kept over all passes. </summary>
+	struct PixelStatistics {
+		VisiblePoint visiblePoint;
+		glm::vec3 directLight = glm::vec3(0); // The emitted and direct lighting, summed over all passes.
+		glm::vec3 flux = glm::vec3(0); // The photon flux gathered within the current radius (tau).
+		float photonCount = 0.0f; // The (reduced) number of photons which have been gathered (N).
+		float radius = 0.0f;
+	};
+
+	/// <summary> How a path continues at a surface (see Scatter). </summary>
+	enum class Scattering {
+		DIFFUSE, SPECULAR, ABSORBED
+	};
+
+	unsigned int width = 0, height = 0, passCount = 0;
+	std::vector<PixelStatistics> pixels;
+
+	/// <summary> The power of every light source (in the order of the scene's emissive render groups). </summary>
+	std::vector<glm::vec3> lightPowers;
+
+	/// <summary> The photons of the current pass, per batch of photon paths. Reused between passes. </summary>
+	std::vector<std::vector<Photon>> photonBatches;
+	std::vector<Photon> photons;
+	PhotonKDTree photonTree;
+
+	/// <summary> The gathered photons of every rendering thread. Reused between passes. </summary>
+	std::vector<std::vector<Photon>> gatheredPhotons;
+
+	/// <summary>
+	/// Traces a camera ray to its visible point. Returns the (weighted) emitted and direct lighting found along the way.
+	/// </summary>
+	glm::vec3 TraceVisiblePoint(const Ray & ray, const glm::vec3 & weight, Sampler & sampler, VisiblePoint & visiblePoint) const;
+
+	/// <summary> Samples the direct lighting of all light sources at a surface point, using shadow rays. </summary>
+	glm::vec3 SampleDirectLighting(const glm::vec3 & position, const glm::vec3 & normal, const glm::vec3 & outDirection,
+								   const Material * material, Sampler & sampler) const;
+
+	/// <summary> Traces the photon paths [first, last) of light source i in the current pass. </summary>
+	void TracePhotons(const unsigned int i, const unsigned int first, const unsigned int last, std::vector<Photon> & batch) const;
+
+	/// <summary> Adds the photons of the current pass around the visible point of a pixel to its flux, and shrinks its radius. </summary>
+	void GatherPhotons(PixelStatistics & pixel, std::vector<Photon> & found) const;
+
+	/// <summary>
+	/// Chooses how a path continues at a hit of a non-emissive surface. The diffuse, refracted and mirrored parts
+	/// of the material (weighted as in PhotonMapRenderer) are chosen with probabilities proportional to their weights, using u.
+	/// Specular scattering moves the ray along the new direction. The weight of the path is multiplied by the sum of
+	/// the weights divided by the probability of the choice.
+	/// </summary>
+	Scattering Scatter(Ray & ray, const glm::vec3 & position, const glm::vec3 & normal, const unsigned int renderGroupIndex,
+					   const float u, glm::vec3 & weight) const;
+
+	/// <summary> Returns the reflectance (the BRDF times pi) of a material, for light arriving along inDirection. </summary>
+	static glm::vec3 Reflectance(const Material * material, const glm::vec3 & inDirection, const glm::vec3 & outDirection, const glm::vec3 & normal);
+};
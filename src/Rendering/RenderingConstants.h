@@ -0,0 +1,10 @@
+#pragma once
+
+// Constants shared by the renderers and the photon maps.
+
+#define __SHADOW_RAY_ORIGIN_OFFSET 0.0001f // Shadow rays start this far above the surface.
+#define __SHADOW_RAY_LIGHT_OFFSET 0.0001f // Shadow rays stop this far in front of the sampled light point.
+#define __RAY_NUDGE_DISTANCE 0.001f // Rays are moved this far forward before they are cast.
+#define __PHOTON_BATCH_SIZE 4096u // The number of photon paths traced (into their own buffers) by one task.
+#define __MIN_DENSITY_ESTIMATE_RADIUS 0.001f // Photon density estimates use at least this radius, so that coincident photons do not divide by zero.
+#define __MIN_NORMAL_SIMILARITY 0.9f // Photons are only used for surfaces which face (almost) the same way.
@@ -0,0 +1,267 @@
+#include "SDTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#include "../../includes/glm/gtc/constants.hpp"
+
+namespace {
+	/// <summary> Adds a value to an atomic float (std::atomic<float> has no fetch_add before C++20). </summary>
+	void AtomicAdd(std::atomic<float> & target, const float value) {
+		float current = target.load(std::memory_order_relaxed);
+		while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+	}
+
+	/// <summary> Returns the quadrant of a point in [0, 1)^2, and moves the point to [0, 1)^2 within the quadrant. </summary>
+	unsigned int ChildQuadrant(glm::vec2 & p) {
+		const unsigned int x = p.x < 0.5f ? 0 : 1;
+		const unsigned int y = p.y < 0.5f ? 0 : 1;
+		p = glm::min(2.0f * p - glm::vec2(x, y), glm::vec2(1.0f - FLT_EPSILON));
+		return x + 2 * y;
+	}
+}
+
+DTree::Node::Node() {
+	for (unsigned int i = 0; i < 4; ++i) {
+		sums[i].store(0.0f, std::memory_order_relaxed);
+		children[i] = 0;
+	}
+}
+
+DTree::Node::Node(const Node & other) {
+	*this = other;
+}
+
+DTree::Node & DTree::Node::operator=(const Node & other) {
+	for (unsigned int i = 0; i < 4; ++i) {
+		sums[i].store(other.sums[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		children[i] = other.children[i];
+	}
+	return *this;
+}
+
+DTree::DTree() : nodes(1), sampleCount(0) { }
+
+DTree::DTree(const DTree & other) : nodes(other.nodes), sampleCount(other.sampleCount.load()) { }
+
+DTree & DTree::operator=(const DTree & other) {
+	nodes = other.nodes;
+	sampleCount = other.sampleCount.load();
+	return *this;
+}
+
+void DTree::Record(const glm::vec3 & direction, const float energy) {
+	++sampleCount;
+	if (!(energy > 0.0f) || !std::isfinite(energy)) {
+		return;
+	}
+	glm::vec2 p = DirectionToSquare(direction);
+	uint32_t index = 0;
+	while (true) {
+		const unsigned int quadrant = ChildQuadrant(p);
+		AtomicAdd(nodes[index].sums[quadrant], energy);
+		if (nodes[index].IsLeaf(quadrant)) {
+			return;
+		}
+		index = nodes[index].children[quadrant];
+	}
+}
+
+glm::vec3 DTree::Sample(glm::vec2 u) const {
+	glm::vec2 origin(0.0f);
+	float size = 1.0f;
+	uint32_t index = 0;
+	while (true) {
+		const Node & node = nodes[index];
+		const float total = node.GetSum();
+		if (total <= 0.0f) {
+			break; // Uniform within the node.
+		}
+
+		// Choose the column (by the energy of its two quadrants) and then the row, and reuse u within the choices.
+		const float leftProbability = (node.sums[0] + node.sums[2]) / total;
+		unsigned int x = 0;
+		if (u.x < leftProbability) {
+			u.x /= leftProbability;
+		}
+		else {
+			x = 1;
+			u.x = (u.x - leftProbability) / (1.0f - leftProbability);
+		}
+		if (node.sums[x] + node.sums[x + 2] <= 0.0f) {
+			x = 1 - x; // Only possible through rounding.
+		}
+		const float bottomProbability = node.sums[x] / (node.sums[x] + node.sums[x + 2]);
+		unsigned int y = 0;
+		if (u.y < bottomProbability) {
+			u.y /= bottomProbability;
+		}
+		else {
+			y = 1;
+			u.y = (u.y - bottomProbability) / (1.0f - bottomProbability);
+		}
+		u = glm::clamp(u, glm::vec2(0.0f), glm::vec2(1.0f - FLT_EPSILON));
+
+		const unsigned int quadrant = x + 2 * y;
+		size *= 0.5f;
+		origin += size * glm::vec2(x, y);
+		if (node.IsLeaf(quadrant)) {
+			break;
+		}
+		index = node.children[quadrant];
+	}
+	return SquareToDirection(origin + size * u);
+}
+
+float DTree::Pdf(const glm::vec3 & direction) const {
+	glm::vec2 p = DirectionToSquare(direction);
+	float pdf = 1.0f;
+	uint32_t index = 0;
+	while (true) {
+		const Node & node = nodes[index];
+		const float total = node.GetSum();
+		if (total <= 0.0f) {
+			break;
+		}
+		const unsigned int quadrant = ChildQuadrant(p);
+		pdf *= 4.0f * node.sums[quadrant] / total;
+		if (node.IsLeaf(quadrant)) {
+			break;
+		}
+		index = node.children[quadrant];
+	}
+	return pdf / (4.0f * glm::pi<float>());
+}
+
+DTree DTree::Refined(const float maxEnergyFraction) const {
+	DTree refined;
+	const float total = nodes[0].GetSum();
+	if (total <= 0.0f) {
+		return refined;
+	}
+
+	// Walk the new tree, following this tree where it has nodes. Below the leaves of this tree
+	// the energy of a quadrant is assumed to be spread evenly over its subquadrants.
+	struct Entry {
+		uint32_t index;
+		int64_t oldIndex; // -1 below the leaves of this tree.
+		float fraction;
+		unsigned int depth;
+	};
+	std::vector<Entry> stack = { { 0, 0, 1.0f, 1 } };
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+		for (unsigned int quadrant = 0; quadrant < 4; ++quadrant) {
+			float fraction = 0.25f * entry.fraction;
+			int64_t oldChild = -1;
+			if (entry.oldIndex >= 0) {
+				const Node & oldNode = nodes[entry.oldIndex];
+				fraction = oldNode.sums[quadrant] / total;
+				if (!oldNode.IsLeaf(quadrant)) {
+					oldChild = oldNode.children[quadrant];
+				}
+			}
+			if (fraction > maxEnergyFraction && entry.depth < MAX_DEPTH) {
+				const uint32_t child = static_cast<uint32_t>(refined.nodes.size());
+				refined.nodes.emplace_back();
+				refined.nodes[entry.index].children[quadrant] = child;
+				stack.push_back({ child, oldChild, fraction, entry.depth + 1 });
+			}
+		}
+	}
+	return refined;
+}
+
+glm::vec2 DTree::DirectionToSquare(const glm::vec3 & direction) {
+	const float cosTheta = glm::clamp(direction.z, -1.0f, 1.0f);
+	float phi = std::atan2(direction.y, direction.x);
+	if (phi < 0.0f) {
+		phi += glm::two_pi<float>();
+	}
+	const glm::vec2 p(0.5f * (cosTheta + 1.0f), phi / glm::two_pi<float>());
+	return glm::clamp(p, glm::vec2(0.0f), glm::vec2(1.0f - FLT_EPSILON));
+}
+
+glm::vec3 DTree::SquareToDirection(const glm::vec2 & p) {
+	const float cosTheta = 2.0f * p.x - 1.0f;
+	const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+	const float phi = glm::two_pi<float>() * p.y;
+	return glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+SDTree::SDTree(const AABB & sceneBounds) : nodes(1) {
+	// The spatial tree splits cubes in halves, so make the bounds a (slightly larger) cube.
+	const glm::vec3 center = 0.5f * (sceneBounds.minimum + sceneBounds.maximum);
+	const glm::vec3 extent = sceneBounds.maximum - sceneBounds.minimum;
+	const float halfSize = 0.505f * std::max(extent.x, std::max(extent.y, extent.z));
+	bounds = AABB(center - glm::vec3(halfSize), center + glm::vec3(halfSize));
+}
+
+void SDTree::Record(const glm::vec3 & position, const glm::vec3 & direction, const float radianceOverPdf) {
+	nodes[GetLeafIndex(position)].building.Record(direction, radianceOverPdf);
+}
+
+void SDTree::Refine(const unsigned int iteration) {
+	// Split the leaves with many samples (each half is assumed to get half of the samples).
+	const float maxSampleCount = SPLIT_THRESHOLD * std::sqrt(std::pow(2.0f, static_cast<float>(iteration)));
+	std::vector<std::pair<uint32_t, float>> stack;
+	for (uint32_t i = 0; i < nodes.size(); ++i) {
+		if (nodes[i].IsLeaf()) {
+			stack.push_back({ i, static_cast<float>(nodes[i].building.GetSampleCount()) });
+		}
+	}
+	while (!stack.empty()) {
+		const uint32_t index = stack.back().first;
+		const float sampleCount = stack.back().second;
+		stack.pop_back();
+		if (sampleCount <= maxSampleCount) {
+			continue;
+		}
+		SNode child;
+		child.axis = (nodes[index].axis + 1) % 3;
+		child.sampling = nodes[index].sampling;
+		child.building = nodes[index].building;
+		nodes[index].sampling = nodes[index].building = DTree();
+		for (unsigned int i = 0; i < 2; ++i) {
+			nodes[index].children[i] = static_cast<uint32_t>(nodes.size());
+			nodes.push_back(child);
+			stack.push_back({ nodes[index].children[i], 0.5f * sampleCount });
+		}
+	}
+
+	// The recorded radiance is sampled in the next iteration, while new trees record it again.
+	for (SNode & node : nodes) {
+		if (node.IsLeaf()) {
+			node.sampling = node.building;
+			node.building = node.sampling.Refined(MAX_ENERGY_FRACTION);
+		}
+	}
+}
+
+size_t SDTree::GetLeafCount() const {
+	return std::count_if(nodes.begin(), nodes.end(), [](const SNode & node) { return node.IsLeaf(); });
+}
+
+double SDTree::GetMeanDirectionalNodeCount() const {
+	size_t nodeCount = 0;
+	for (const SNode & node : nodes) {
+		if (node.IsLeaf()) {
+			nodeCount += node.sampling.Size();
+		}
+	}
+	return nodeCount / static_cast<double>(GetLeafCount());
+}
+
+uint32_t SDTree::GetLeafIndex(const glm::vec3 & position) const {
+	glm::vec3 p = glm::clamp((position - bounds.minimum) / (bounds.maximum - bounds.minimum), glm::vec3(0.0f), glm::vec3(1.0f - FLT_EPSILON));
+	uint32_t index = 0;
+	while (!nodes[index].IsLeaf()) {
+		const unsigned int axis = nodes[index].axis;
+		const unsigned int child = p[axis] < 0.5f ? 0 : 1;
+		p[axis] = std::min(2.0f * p[axis] - child, 1.0f - FLT_EPSILON);
+		index = nodes[index].children[child];
+	}
+	return index;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include <glm.hpp>
+
+#include "../Geometry/AABB.h"
+
+/// <summary>
+/// A distribution over all directions, stored as a quadtree over the square [0, 1)^2, which maps to the sphere by
+/// (cos(theta), phi) (an area preserving mapping). Every node holds the energy recorded in each of its four quadrants.
+/// Recording is thread-safe, so all rendering threads can record into the same tree.
+/// </summary>
+class DTree {
+public:
+	/// <summary> Creates a tree with a single (leaf) node and no recorded energy. </summary>
+	DTree();
+
+	/// <summary> Adds energy to the leaf which contains a direction, and counts the sample. Thread-safe. </summary>
+	void Record(const glm::vec3 & direction, const float energy);
+
+	/// <summary> Returns true if any energy is recorded. Directions should only be sampled from trees with energy. </summary>
+	bool HasEnergy() const { return nodes[0].GetSum() > 0.0f; }
+
+	/// <summary> Returns a direction drawn proportionally to the recorded energy, using the sample point u in [0, 1)^2. </summary>
+	glm::vec3 Sample(glm::vec2 u) const;
+
+	/// <summary> Returns the solid angle pdf with which Sample returns a direction. </summary>
+	float Pdf(const glm::vec3 & direction) const;
+
+	/// <summary> Returns the number of recorded samples. </summary>
+	uint32_t GetSampleCount() const { return sampleCount; }
+
+	/// <summary> Returns the number of nodes. </summary>
+	size_t Size() const { return nodes.size(); }
+
+	/// <summary>
+	/// Returns a tree without energy, whose leaves are split until each holds at most the given fraction of this tree's
+	/// energy (or MAX_DEPTH is reached). Quadrants which hold less are merged into leaves.
+	/// </summary>
+	DTree Refined(const float maxEnergyFraction) const;
+
+	DTree(const DTree & other);
+	DTree & operator=(const DTree & other);
+
+private:
+	static const unsigned int MAX_DEPTH = 20;
+
+	/// <summary> A node, with the energy and the child node index of every quadrant (0 if the quadrant is a leaf). </summary>
+	struct Node {
+		std::atomic<float> sums[4];
+		uint32_t children[4];
+
+		Node();
+		Node(const Node & other);
+		Node & operator=(const Node & other);
+
+		float GetSum() const { return sums[0] + sums[1] + sums[2] + sums[3]; }
+		bool IsLeaf(const unsigned int quadrant) const { return children[quadrant] == 0; }
+	};
+
+	std::vector<Node> nodes;
+	std::atomic<uint32_t> sampleCount;
+
+	/// <summary> Maps a direction to the square [0, 1)^2, and back. </summary>
+	static glm::vec2 DirectionToSquare(const glm::vec3 & direction);
+	static glm::vec3 SquareToDirection(const glm::vec2 & p);
+};
+
+/// <summary>
+/// A spatial-directional tree (Müller et al., "Practical Path Guiding for Efficient Light-Transport Simulation", 2017),
+/// which learns the incident radiance of a scene. A binary tree subdivides the scene bounds (splitting the axes in turn),
+/// and every leaf holds two directional trees: one to sample from, and one which records the radiance of finished paths.
+/// Training happens in iterations. After every iteration, leaves with many samples are split, and the recorded trees
+/// become the sampling trees (see Refine). The structure only changes in Refine, so Record and the lookups can run concurrently.
+/// </summary>
+class SDTree {
+public:
+	/// <param name='bounds'> The bounds of the scene. </param>
+	SDTree(const AABB & bounds);
+
+	/// <summary> Returns the tree to sample directions from at a position. </summary>
+	const DTree & GetSamplingTree(const glm::vec3 & position) const { return nodes[GetLeafIndex(position)].sampling; }
+
+	/// <summary> Records incident radiance (divided by the pdf of its direction) at a position. Thread-safe. </summary>
+	void Record(const glm::vec3 & position, const glm::vec3 & direction, const float radianceOverPdf);
+
+	/// <summary>
+	/// Ends a training iteration. Leaves which recorded more than SPLIT_THRESHOLD * sqrt(2^iteration) samples are split,
+	/// the recorded trees become the sampling trees, and new empty recording trees are refined from them.
+	/// </summary>
+	void Refine(const unsigned int iteration);
+
+	/// <summary> Returns the number of spatial leaves. </summary>
+	size_t GetLeafCount() const;
+
+	/// <summary> Returns the mean number of nodes of the sampling trees. </summary>
+	double GetMeanDirectionalNodeCount() const;
+
+private:
+	const float SPLIT_THRESHOLD = 1000.0f; // The number of samples (times sqrt(2^iteration)) above which a spatial leaf is split.
+	const float MAX_ENERGY_FRACTION = 0.01f; // The largest fraction of the energy of a directional tree held by one of its leaves.
+
+	/// <summary> A node of the spatial tree. Leaves have no children (children[0] == 0) and hold directional trees. </summary>
+	struct SNode {
+		uint32_t children[2] = { 0, 0 };
+		unsigned int axis = 0;
+		DTree sampling, building;
+
+		bool IsLeaf() const { return children[0] == 0; }
+	};
+
+	AABB bounds;
+	std::vector<SNode> nodes;
+
+	/// <summary> Returns the index of the leaf which contains a position. </summary>
+	uint32_t GetLeafIndex(const glm::vec3 & position) const;
+};
@@ -0,0 +1,124 @@
+#include "BlueNoiseSampler.h"
+
+#include <cmath>
+#include <cfloat>
+
+#include "../../Utility/Random.h"
+
+#define __BLUE_NOISE_SIGMA 1.5f // The standard deviation (in pixels) of the energy filter used to find voids and clusters.
+
+BlueNoiseSampler::BlueNoiseSampler() : SobolSampler("Blue noise dithered Owen-scrambled Sobol") {
+	// The mask is generated once (thread safely) when the first sampler is created.
+	static const std::vector<float> sharedMask = GenerateMask();
+	mask = &sharedMask;
+}
+
+void BlueNoiseSampler::StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int _sampleIndex) {
+	// Use the same sequence for every pixel. The pixels are decorrelated by the shifts instead.
+	Sampler::StartPixelSample(x, y, _sampleIndex);
+	pixelSeed = 0;
+}
+
+float BlueNoiseSampler::Get1D() {
+	const float shift = GetShift(dimension);
+	return Wrap(SobolSampler::Get1D() + shift);
+}
+
+glm::vec2 BlueNoiseSampler::Get2D() {
+	const glm::vec2 shift(GetShift(dimension), GetShift(dimension + 1));
+	const glm::vec2 u = SobolSampler::Get2D();
+	return glm::vec2(Wrap(u.x + shift.x), Wrap(u.y + shift.y));
+}
+
+float BlueNoiseSampler::GetShift(const unsigned int d) const {
+	const uint32_t offset = Hash(d, 0x5bd1e995u);
+	const unsigned int x = (pixelX + offset) & (MASK_SIZE - 1);
+	const unsigned int y = (pixelY + (offset >> 16)) & (MASK_SIZE - 1);
+	return (*mask)[y * MASK_SIZE + x];
+}
+
+std::vector<float> BlueNoiseSampler::GenerateMask() {
+	const unsigned int N = MASK_SIZE * MASK_SIZE;
+
+	// The energy filter, indexed by the (toroidal) offset between two pixels.
+	std::vector<float> filter(N);
+	for (unsigned int y = 0; y < MASK_SIZE; ++y) {
+		for (unsigned int x = 0; x < MASK_SIZE; ++x) {
+			const float dx = static_cast<float>(std::min(x, MASK_SIZE - x));
+			const float dy = static_cast<float>(std::min(y, MASK_SIZE - y));
+			filter[y * MASK_SIZE + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * __BLUE_NOISE_SIGMA * __BLUE_NOISE_SIGMA));
+		}
+	}
+
+	// The energy of a pixel is the filtered density of the set pixels around it.
+	std::vector<bool> pattern(N, false);
+	std::vector<float> energy(N, 0.0f);
+	const auto setPixel = [&](const unsigned int p, const bool value) {
+		pattern[p] = value;
+		const float sign = value ? 1.0f : -1.0f;
+		const unsigned int px = p % MASK_SIZE, py = p / MASK_SIZE;
+		for (unsigned int y = 0; y < MASK_SIZE; ++y) {
+			for (unsigned int x = 0; x < MASK_SIZE; ++x) {
+				energy[y * MASK_SIZE + x] += sign * filter[((y - py) & (MASK_SIZE - 1)) * MASK_SIZE + ((x - px) & (MASK_SIZE - 1))];
+			}
+		}
+	};
+
+	// The tightest cluster is the set pixel with the highest energy, and the largest void is the unset pixel with the lowest.
+	const auto findExtreme = [&](const bool value) {
+		unsigned int best = 0;
+		float bestEnergy = value ? -FLT_MAX : FLT_MAX;
+		for (unsigned int p = 0; p < N; ++p) {
+			if (pattern[p] == value && (value ? energy[p] > bestEnergy : energy[p] < bestEnergy)) {
+				best = p;
+				bestEnergy = energy[p];
+			}
+		}
+		return best;
+	};
+
+	// Start with a random pattern and move pixels from the tightest clusters to the largest voids until it is uniform.
+	Utility::RandomGenerator random(MASK_SIZE);
+	unsigned int initialCount = 0;
+	while (initialCount < N / 10) {
+		const unsigned int p = random.NextUInt(N);
+		if (!pattern[p]) {
+			setPixel(p, true);
+			++initialCount;
+		}
+	}
+	while (true) {
+		const unsigned int cluster = findExtreme(true);
+		setPixel(cluster, false);
+		const unsigned int largestVoid = findExtreme(false);
+		setPixel(largestVoid, true);
+		if (largestVoid == cluster) {
+			break;
+		}
+	}
+	const std::vector<bool> initialPattern = pattern;
+	const std::vector<float> initialEnergy = energy;
+
+	// Rank the initial pixels by removing the tightest clusters first.
+	std::vector<unsigned int> ranks(N);
+	for (unsigned int rank = initialCount; rank > 0; --rank) {
+		const unsigned int cluster = findExtreme(true);
+		setPixel(cluster, false);
+		ranks[cluster] = rank - 1;
+	}
+
+	// Rank the remaining pixels by filling the largest voids first.
+	pattern = initialPattern;
+	energy = initialEnergy;
+	for (unsigned int rank = initialCount; rank < N; ++rank) {
+		const unsigned int largestVoid = findExtreme(false);
+		setPixel(largestVoid, true);
+		ranks[largestVoid] = rank;
+	}
+
+	std::vector<float> result(N);
+	for (unsigned int p = 0; p < N; ++p) {
+		result[p] = (ranks[p] + 0.5f) / N;
+	}
+	return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "SobolSampler.h"
+
+/// <summary>
+/// Owen-scrambled Sobol sampler whose error is distributed as blue noise in screen space
+/// (see Georgiev and Fajardo, "Blue-noise Dithered Sampling", 2016). All pixels use the same scrambled sequence,
+/// which every pixel shifts toroidally by the value of a blue noise mask. Every dimension reads the mask at a
+/// different offset. Neighbouring pixels thereby get dissimilar shifts, which turns the remaining noise into
+/// high frequency noise that is perceived as less disturbing (and is removed well by filtering).
+/// </summary>
+class BlueNoiseSampler : public SobolSampler {
+public:
+	BlueNoiseSampler();
+	void StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int sampleIndex) override;
+	float Get1D() override;
+	glm::vec2 Get2D() override;
+private:
+	/// <summary> The width and height of the (tiled) blue noise mask. Must be a power of two. </summary>
+	static const unsigned int MASK_SIZE = 64;
+
+	/// <summary> The blue noise mask, shared by all blue noise samplers. </summary>
+	const std::vector<float> * mask;
+
+	/// <summary> Returns the shift of the current pixel for the given dimension. </summary>
+	float GetShift(const unsigned int dimension) const;
+
+	/// <summary>
+	/// Generates a MASK_SIZE x MASK_SIZE blue noise mask with values in (0, 1) using the void-and-cluster method
+	/// (see Ulichney, "The void-and-cluster method for dither array generation", 1993).
+	/// </summary>
+	static std::vector<float> GenerateMask();
+};
@@ -0,0 +1,74 @@
+#include "HaltonSampler.h"
+
+const unsigned int HaltonSampler::PRIMES[HaltonSampler::PRIME_COUNT] = {
+	2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+	59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+};
+
+HaltonSampler::HaltonSampler() : Sampler("Halton") { }
+
+void HaltonSampler::StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int _sampleIndex) {
+	Sampler::StartPixelSample(x, y, _sampleIndex);
+	pixelSeed = Hash(x, y);
+	random = Utility::RandomGenerator(pixelSeed, sampleIndex);
+}
+
+float HaltonSampler::Get1D() {
+	const unsigned int d = dimension++;
+	if (d >= PRIME_COUNT) {
+		return random.NextFloat();
+	}
+	return ScrambledRadicalInverse(PRIMES[d], sampleIndex, Hash(pixelSeed, d));
+}
+
+glm::vec2 HaltonSampler::Get2D() {
+	const float u = Get1D();
+	return glm::vec2(u, Get1D());
+}
+
+float HaltonSampler::ScrambledRadicalInverse(const unsigned int base, unsigned int index, const uint32_t seed) {
+	const double invBase = 1.0 / base;
+	double invBaseN = 1.0;
+	unsigned long long reversedDigits = 0;
+	while (index > 0) {
+		const unsigned int next = index / base;
+		const unsigned int digit = PermutationElement(index - next * base, base, Hash(seed, static_cast<uint32_t>(reversedDigits)));
+		reversedDigits = reversedDigits * base + digit;
+		invBaseN *= invBase;
+		index = next;
+	}
+	// Scrambling the remaining (zero) digits places the result uniformly within the interval given by the scrambled digits.
+	const float result = static_cast<float>((reversedDigits + ToFloat(Hash(seed, static_cast<uint32_t>(reversedDigits) ^ 0xa511e9b3u))) * invBaseN);
+	return result < ONE_MINUS_EPSILON ? result : ONE_MINUS_EPSILON;
+}
+
+unsigned int HaltonSampler::PermutationElement(uint32_t i, const uint32_t n, const uint32_t seed) {
+	// Hash i within the smallest power of two which contains n, until the result is in [0, n) (cycle walking).
+	uint32_t w = n - 1;
+	w |= w >> 1;
+	w |= w >> 2;
+	w |= w >> 4;
+	w |= w >> 8;
+	w |= w >> 16;
+	do {
+		i ^= seed;
+		i *= 0xe170893du;
+		i ^= seed >> 16;
+		i ^= (i & w) >> 4;
+		i ^= seed >> 8;
+		i *= 0x0929eb3fu;
+		i ^= seed >> 23;
+		i ^= (i & w) >> 1;
+		i *= 1 | seed >> 27;
+		i *= 0x6935fa69u;
+		i ^= (i & w) >> 11;
+		i *= 0x74dcb303u;
+		i ^= (i & w) >> 2;
+		i *= 0x9e501cc3u;
+		i ^= (i & w) >> 2;
+		i *= 0xc860a3dfu;
+		i &= w;
+		i ^= i >> 5;
+	} while (i >= n);
+	return (i + seed) % n;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Sampler.h"
+#include "../../Utility/Random.h"
+
+/// <summary>
+/// Sampler using the Halton sequence, i.e. the radical inverse of the sample index in the i:th prime base for dimension i.
+/// The digits are Owen-scrambled, i.e. every digit is permuted by a random permutation given by the pixel, the dimension
+/// and the preceding digits. This decorrelates the pixels and breaks up the clustering of the (plain) Halton sequence
+/// in the higher dimensions. Dimensions beyond the prime table fall back to uniform random values.
+/// </summary>
+class HaltonSampler : public Sampler {
+public:
+	HaltonSampler();
+	void StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int sampleIndex) override;
+	float Get1D() override;
+	glm::vec2 Get2D() override;
+private:
+	/// <summary> The number of dimensions which use the Halton sequence. </summary>
+	static const unsigned int PRIME_COUNT = 32;
+	static const unsigned int PRIMES[PRIME_COUNT];
+
+	/// <summary> The seed which decorrelates the pixels. </summary>
+	uint32_t pixelSeed = 0;
+
+	/// <summary> Generates the values of the dimensions beyond the prime table. </summary>
+	Utility::RandomGenerator random;
+
+	/// <summary> 
+	/// Returns the radical inverse of index in the given base, i.e. its digits mirrored around the decimal point,
+	/// with the digits scrambled by the permutations given by the seed.
+	/// </summary>
+	static float ScrambledRadicalInverse(const unsigned int base, unsigned int index, const uint32_t seed);
+
+	/// <summary> Returns element i of the random permutation of [0, n) given by the seed (see Kensler, "Correlated Multi-Jittered Sampling", 2013). </summary>
+	static unsigned int PermutationElement(uint32_t i, const uint32_t n, const uint32_t seed);
+};
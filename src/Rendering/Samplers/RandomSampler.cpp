@@ -0,0 +1,18 @@
+#include "RandomSampler.h"
+
+RandomSampler::RandomSampler() : Sampler("Random") { }
+
+void RandomSampler::StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int _sampleIndex) {
+	Sampler::StartPixelSample(x, y, _sampleIndex);
+	random = Utility::RandomGenerator((static_cast<uint64_t>(x) << 32) | y, sampleIndex);
+}
+
+float RandomSampler::Get1D() {
+	++dimension;
+	return random.NextFloat();
+}
+
+glm::vec2 RandomSampler::Get2D() {
+	const float u = Get1D();
+	return glm::vec2(u, Get1D());
+}
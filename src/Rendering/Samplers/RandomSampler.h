@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Sampler.h"
+#include "../../Utility/Random.h"
+
+/// <summary>
+/// Reference sampler which returns independent uniform random values for every dimension.
+/// The random sequence of a sample is given by its pixel and sample index.
+/// </summary>
+class RandomSampler : public Sampler {
+public:
+	RandomSampler();
+	void StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int sampleIndex) override;
+	float Get1D() override;
+	glm::vec2 Get2D() override;
+private:
+	Utility::RandomGenerator random;
+};
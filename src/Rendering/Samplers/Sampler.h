@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+#include <glm.hpp>
+
+/// <summary> The samplers which can be used to generate the sample values of the camera rays. </summary>
+enum class SamplerType {
+	RANDOM, HALTON, SOBOL, BLUE_NOISE_SOBOL
+};
+
+/// <summary>
+/// Abstract base class for samplers, which generate the sample values used to render a pixel.
+/// Every sample of a pixel is a point in the (unbounded dimensional) unit cube [0, 1)^d. The first two dimensions
+/// give the position within the pixel, and the following ones are requested in order by the renderer
+/// (e.g. to choose light positions and bounce directions). A sampler is used by one thread at a time.
+/// </summary>
+class Sampler {
+public:
+	const std::string SAMPLER_NAME = "Unknown Name";
+
+	virtual ~Sampler() {}
+
+	/// <summary> Starts the given sample of the pixel (x, y). The next requested dimension is the first one. </summary>
+	virtual void StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int _sampleIndex) {
+		pixelX = x;
+		pixelY = y;
+		sampleIndex = _sampleIndex;
+		dimension = 0;
+	}
+
+	/// <summary> Returns the next dimension of the current sample. </summary>
+	virtual float Get1D() = 0;
+
+	/// <summary> Returns the next two dimensions of the current sample. </summary>
+	virtual glm::vec2 Get2D() = 0;
+
+	/// <summary> Returns an index in [0, n) given by the next dimension of the current sample. </summary>
+	unsigned int GetIndex(const unsigned int n) {
+		return std::min(static_cast<unsigned int>(Get1D() * n), n - 1);
+	}
+
+protected:
+	Sampler(const std::string NAME) : SAMPLER_NAME(NAME) { }
+
+	/// <summary> The current pixel and sample. </summary>
+	unsigned int pixelX = 0, pixelY = 0, sampleIndex = 0;
+
+	/// <summary> The next dimension of the current sample. </summary>
+	unsigned int dimension = 0;
+
+	/// <summary> The largest float below 1. </summary>
+	static constexpr float ONE_MINUS_EPSILON = 0.99999994f;
+
+	/// <summary> Wraps a value around [0, 1) (used for toroidal shifts of sample values). </summary>
+	static float Wrap(float v) {
+		v -= std::floor(v);
+		return v < ONE_MINUS_EPSILON ? v : ONE_MINUS_EPSILON;
+	}
+
+	/// <summary> Converts the highest 24 bits of an integer into a float in [0, 1). </summary>
+	static float ToFloat(const uint32_t x) {
+		return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+	}
+
+	/// <summary> Hashes two integers into one (used to derive seeds for pixels and dimensions). </summary>
+	static uint32_t Hash(uint32_t a, const uint32_t b) {
+		a ^= b * 0x9e3779b9u + 0x7f4a7c15u;
+		a ^= a >> 16;
+		a *= 0x21f0aaadu;
+		a ^= a >> 15;
+		a *= 0x735a2d97u;
+		a ^= a >> 15;
+		return a;
+	}
+};
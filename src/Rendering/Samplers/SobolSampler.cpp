@@ -0,0 +1,83 @@
+#include "SobolSampler.h"
+
+namespace {
+	/// <summary>
+	/// The second Sobol dimension (given by the primitive polynomial x + 1) of every value of every byte of the index,
+	/// so that a sample can be computed using four lookups instead of one step per index bit.
+	/// </summary>
+	struct SecondDimensionTable {
+		uint32_t bytes[4][256];
+
+		SecondDimensionTable() {
+			uint32_t directions[32];
+			directions[0] = 1u << 31;
+			for (unsigned int bit = 1; bit < 32; ++bit) {
+				directions[bit] = directions[bit - 1] ^ (directions[bit - 1] >> 1);
+			}
+			for (unsigned int byte = 0; byte < 4; ++byte) {
+				for (unsigned int value = 0; value < 256; ++value) {
+					uint32_t result = 0;
+					for (unsigned int bit = 0; bit < 8; ++bit) {
+						if (value & (1u << bit)) {
+							result ^= directions[8 * byte + bit];
+						}
+					}
+					bytes[byte][value] = result;
+				}
+			}
+		}
+	};
+	const SecondDimensionTable SECOND_DIMENSION;
+
+	uint32_t ReverseBits(uint32_t x) {
+		x = (x << 16) | (x >> 16);
+		x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+		x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+		x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+		x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+		return x;
+	}
+}
+
+SobolSampler::SobolSampler() : SobolSampler("Owen-scrambled Sobol") { }
+
+SobolSampler::SobolSampler(const std::string NAME) : Sampler(NAME) { }
+
+void SobolSampler::StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int _sampleIndex) {
+	Sampler::StartPixelSample(x, y, _sampleIndex);
+	pixelSeed = Hash(x, y);
+}
+
+float SobolSampler::Get1D() {
+	const uint32_t seed = Hash(pixelSeed, dimension++);
+	const uint32_t index = NestedUniformScramble(sampleIndex, seed);
+	return ToFloat(NestedUniformScramble(Sobol(index, 0), Hash(seed, 1)));
+}
+
+glm::vec2 SobolSampler::Get2D() {
+	const uint32_t seed = Hash(pixelSeed, dimension);
+	dimension += 2;
+	const uint32_t index = NestedUniformScramble(sampleIndex, seed);
+	return glm::vec2(ToFloat(NestedUniformScramble(Sobol(index, 0), Hash(seed, 1))),
+					 ToFloat(NestedUniformScramble(Sobol(index, 1), Hash(seed, 2))));
+}
+
+uint32_t SobolSampler::Sobol(const uint32_t index, const unsigned int dimension) {
+	// The generator matrix of the first dimension is the identity, which gives the van der Corput sequence.
+	if (dimension == 0) {
+		return ReverseBits(index);
+	}
+	return SECOND_DIMENSION.bytes[0][index & 0xff] ^ SECOND_DIMENSION.bytes[1][(index >> 8) & 0xff] ^
+		   SECOND_DIMENSION.bytes[2][(index >> 16) & 0xff] ^ SECOND_DIMENSION.bytes[3][index >> 24];
+}
+
+uint32_t SobolSampler::NestedUniformScramble(uint32_t x, const uint32_t seed) {
+	// A Laine-Karras style permutation (which only lets bits affect higher bits) applied to the reversed bits.
+	x = ReverseBits(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return ReverseBits(x);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Sampler.h"
+
+/// <summary>
+/// Sampler using the Owen-scrambled Sobol sequence (see Burley, "Practical Hash-based Owen Scrambling", 2020).
+/// Every 1D or 2D request uses the first one or two Sobol dimensions, which form a (0, 2)-sequence. The requests are
+/// decorrelated by shuffling the sample index and scrambling the result with hashed seeds per pixel and dimension.
+/// Taking the first 2^k samples of a pixel gives a well stratified (0, k, 2)-net in every pair of dimensions.
+/// </summary>
+class SobolSampler : public Sampler {
+public:
+	SobolSampler();
+	void StartPixelSample(const unsigned int x, const unsigned int y, const unsigned int sampleIndex) override;
+	float Get1D() override;
+	glm::vec2 Get2D() override;
+protected:
+	SobolSampler(const std::string NAME);
+
+	/// <summary> The seed which decorrelates the pixels. </summary>
+	uint32_t pixelSeed = 0;
+
+	/// <summary> Returns the given element of the first (dimension = 0) or second (dimension = 1) Sobol dimension. </summary>
+	static uint32_t Sobol(const uint32_t index, const unsigned int dimension);
+
+	/// <summary> Applies a random (given by the seed) Owen scrambling, i.e. a nested uniform permutation of the bits. </summary>
+	static uint32_t NestedUniformScramble(uint32_t x, const uint32_t seed);
+};
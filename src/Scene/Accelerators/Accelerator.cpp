@@ -0,0 +1,85 @@
+#include "Accelerator.h"
+
+#include <cassert>
+
+#include "../Scene.h"
+
+void Accelerator::Build() {
+	primitiveReferences.clear();
+	std::vector<AABB> primitiveBounds;
+	for (unsigned int i = 0; i < scene.renderGroups.size(); ++i) {
+		for (unsigned int j = 0; j < scene.renderGroups[i].primitives.size(); ++j) {
+			primitiveReferences.push_back({ i, j });
+			primitiveBounds.push_back(scene.renderGroups[i].primitives[j]->GetAxisAlignedBoundingBox());
+		}
+	}
+	BuildStructure(primitiveBounds);
+
+	primitiveBuffer.Clear();
+	for (const auto & reference : primitiveReferences) {
+		primitiveBuffer.Add(scene.renderGroups[reference.renderGroupIndex].primitives[reference.primitiveIndex]);
+	}
+}
+
+void Accelerator::UpdateRenderGroups() {
+	Build();
+}
+
+bool Accelerator::RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	float closestInterectionDistance = ray.tMax;
+	bool hit = false;
+
+	const auto & renderGroup = scene.renderGroups[renderGroupIndex];
+
+	// Reject the whole render group if the ray misses its AABB.
+	if (!renderGroup.axisAlignedBoundingBox.RayIntersection(ray)) {
+		intersectionDistance = closestInterectionDistance;
+		return false;
+	}
+
+	for (unsigned int j = 0; j < renderGroup.primitives.size(); ++j) {
+		if (!renderGroup.primitives[j]->enabled) {
+			continue;
+		}
+		bool intersects = renderGroup.primitives[j]->RayIntersection(ray, intersectionDistance);
+		if (intersects) {
+			assert(intersectionDistance > FLT_EPSILON);
+			if (intersectionDistance < closestInterectionDistance) {
+				intersectionPrimitiveIndex = j;
+				closestInterectionDistance = intersectionDistance;
+				hit = true;
+			}
+		}
+	}
+
+	intersectionDistance = hit ? closestInterectionDistance : FLT_MAX;
+	return hit;
+}
+
+void Accelerator::RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const {
+	for (unsigned int i = 0; i < count; ++i) {
+		RayCast(rays[i], intersections[i].renderGroupIndex, intersections[i].primitiveIndex, intersections[i].distance);
+	}
+}
+
+void Accelerator::AddPrimitiveReference(const PrimitiveReference & reference) {
+	primitiveReferences.push_back(reference);
+	primitiveBuffer.Add(scene.renderGroups[reference.renderGroupIndex].primitives[reference.primitiveIndex]);
+}
+
+bool Accelerator::IsEnabled(const PrimitiveReference & reference) const {
+	const auto & renderGroup = scene.renderGroups[reference.renderGroupIndex];
+	return renderGroup.enabled && renderGroup.primitives[reference.primitiveIndex]->enabled;
+}
+
+void Accelerator::AppendPrimitiveIntersections(const unsigned int referenceIndex, const Ray & ray, std::vector<Intersection> & intersections) const {
+	const auto & reference = primitiveReferences[referenceIndex];
+	if (!IsEnabled(reference)) {
+		return;
+	}
+	float intersectionDistances[Primitive::MAX_RAY_INTERSECTIONS];
+	const unsigned int count = primitiveBuffer.RayIntersections(referenceIndex, ray, intersectionDistances);
+	for (unsigned int i = 0; i < count; ++i) {
+		intersections.push_back({ reference.renderGroupIndex, reference.primitiveIndex, intersectionDistances[i] });
+	}
+}
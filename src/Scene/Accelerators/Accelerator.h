@@ -0,0 +1,185 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../../Geometry/Ray.h"
+#include "../../Geometry/AABB.h"
+#include "PrimitiveBuffer.h"
+
+/// <summary> The acceleration structures which can be used for ray casting. </summary>
+enum class AcceleratorType {
+	BRUTE_FORCE, OCTREE, BOUNDING_VOLUME_HIERARCHY, TWO_LEVEL_BOUNDING_VOLUME_HIERARCHY
+};
+
+/// <summary> An intersection between a ray and a primitive in the scene. </summary>
+struct Intersection {
+	unsigned int renderGroupIndex, primitiveIndex;
+	float distance;
+};
+
+/// <summary> 
+/// Abstract base class for acceleration structures used to speed up ray casting in a scene.
+/// </summary>
+class Accelerator {
+public:
+	const std::string ACCELERATOR_NAME = "Unknown Name";
+
+	/// <summary> The maximum number of rays in a packet passed to RayCastPacket. </summary>
+	static const unsigned int MAX_PACKET_SIZE = 64;
+
+	/// <summary> References a primitive in the scene using its render group index and primitive index. </summary>
+	struct PrimitiveReference {
+		unsigned int renderGroupIndex, primitiveIndex;
+	};
+
+	virtual ~Accelerator() {}
+
+	/// <summary> (Re)builds the acceleration structure over all primitives in the scene. </summary>
+	void Build();
+
+	/// <summary> 
+	/// Casts a ray through the scene. Returns true if there was an intersection.
+	/// See Scene::RayCast.
+	/// </summary>
+	virtual bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const = 0;
+
+	/// <summary> 
+	/// Returns true if the ray hits any primitive closer than tMax.
+	/// See Scene::Occluded.
+	/// </summary>
+	virtual bool Occluded(const Ray & ray, const float tMax) const = 0;
+
+	/// <summary> 
+	/// Appends all intersections between the ray and the scene to the given vector.
+	/// The intersections are unordered and may contain duplicates. See Scene::RayCastAll.
+	/// </summary>
+	virtual void RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const = 0;
+
+	/// <summary> 
+	/// Casts a packet of at most MAX_PACKET_SIZE coherent rays through the scene. See Scene::RayCastPacket.
+	/// Casts the rays one by one by default.
+	/// </summary>
+	virtual void RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const;
+
+	/// <summary> 
+	/// Casts a ray through a single render group. Returns true if there was an intersection.
+	/// See Scene::RenderGroupRayCast. Tests every primitive in the render group by default.
+	/// </summary>
+	virtual bool RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const;
+
+	/// <summary> 
+	/// Updates the acceleration structure after render groups have been enabled, disabled or appended to the scene.
+	/// Rebuilds the whole structure by default.
+	/// </summary>
+	virtual void UpdateRenderGroups();
+
+protected:
+	Accelerator(const std::string NAME, const class Scene & _scene) : ACCELERATOR_NAME(NAME), scene(_scene) { }
+	const class Scene & scene;
+
+	/// <summary> All primitives in the scene. Acceleration structures reference primitives using indices into this vector. </summary>
+	std::vector<PrimitiveReference> primitiveReferences;
+
+	/// <summary> The geometry of every primitive reference (entry i belongs to primitive reference i). </summary>
+	PrimitiveBuffer primitiveBuffer;
+
+	/// <summary> 
+	/// Builds the acceleration structure given the bounding boxes of all primitive references.
+	/// The primitive references may be reordered (e.g. to make the primitives of a leaf contiguous in memory).
+	/// The primitive buffer is filled in after this.
+	/// </summary>
+	virtual void BuildStructure(const std::vector<AABB> & primitiveBounds) = 0;
+
+	/// <summary> Adds a primitive reference and its geometry. </summary>
+	void AddPrimitiveReference(const PrimitiveReference & reference);
+
+	/// <summary> Returns true if a referenced primitive and its render group are enabled. </summary>
+	bool IsEnabled(const PrimitiveReference & reference) const;
+
+	/// <summary>
+	/// Intersects a referenced primitive. Disabled primitives and render groups are ignored.
+	/// Returns true (and updates the closest intersection) if the primitive is hit closer than the closest intersection.
+	/// </summary>
+	inline bool IntersectPrimitive(const unsigned int referenceIndex, const Ray & ray, float & closestIntersectionDistance,
+								   unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex) const;
+
+	/// <summary> Returns true if a referenced primitive is hit closer than tMax. Disabled primitives and render groups are ignored. </summary>
+	inline bool PrimitiveOccludes(const unsigned int referenceIndex, const Ray & ray, const float tMax) const;
+
+	/// <summary>
+	/// Intersects the consecutive primitive references [first, first + count), PrimitiveBuffer::SIMD_WIDTH at a time.
+	/// Gives the same result as calling IntersectPrimitive for every reference in order.
+	/// </summary>
+	inline bool IntersectPrimitives(const unsigned int first, const unsigned int count, const Ray & ray, float & closestIntersectionDistance,
+									unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex) const;
+
+	/// <summary> Returns true if any of the primitive references [first, first + count) is hit closer than tMax. See PrimitiveOccludes. </summary>
+	inline bool PrimitivesOcclude(const unsigned int first, const unsigned int count, const Ray & ray, const float tMax) const;
+
+	/// <summary> Appends all intersections with a referenced primitive. Disabled primitives and render groups are ignored. </summary>
+	void AppendPrimitiveIntersections(const unsigned int referenceIndex, const Ray & ray, std::vector<Intersection> & intersections) const;
+};
+
+bool Accelerator::IntersectPrimitive(const unsigned int referenceIndex, const Ray & ray, float & closestIntersectionDistance,
+									 unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex) const {
+	// Rays rarely hit the primitives they are tested against, so the enabled flags are only looked up for hits.
+	float intersectionDistance;
+	if (!primitiveBuffer.RayIntersection(referenceIndex, ray, intersectionDistance) || intersectionDistance >= closestIntersectionDistance) {
+		return false;
+	}
+	const PrimitiveReference & reference = primitiveReferences[referenceIndex];
+	if (!IsEnabled(reference)) {
+		return false;
+	}
+	intersectionRenderGroupIndex = reference.renderGroupIndex;
+	intersectionPrimitiveIndex = reference.primitiveIndex;
+	closestIntersectionDistance = intersectionDistance;
+	return true;
+}
+
+bool Accelerator::PrimitiveOccludes(const unsigned int referenceIndex, const Ray & ray, const float tMax) const {
+	float intersectionDistance;
+	return primitiveBuffer.RayIntersection(referenceIndex, ray, intersectionDistance) && intersectionDistance < tMax &&
+		IsEnabled(primitiveReferences[referenceIndex]);
+}
+
+bool Accelerator::IntersectPrimitives(const unsigned int first, const unsigned int count, const Ray & ray, float & closestIntersectionDistance,
+									  unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex) const {
+	bool hit = false;
+	float intersectionDistances[PrimitiveBuffer::SIMD_WIDTH];
+	for (unsigned int i = first; i < first + count; i += PrimitiveBuffer::SIMD_WIDTH) {
+		const unsigned int width = std::min(PrimitiveBuffer::SIMD_WIDTH, first + count - i);
+		unsigned int mask = primitiveBuffer.RayIntersectionMask(i, width, ray, closestIntersectionDistance, intersectionDistances);
+		// Process the hits in order, since a closer hit found in the same batch may reject a later one.
+		for (unsigned int lane = 0; mask != 0; ++lane, mask >>= 1) {
+			if ((mask & 1) == 0 || intersectionDistances[lane] >= closestIntersectionDistance) {
+				continue;
+			}
+			const PrimitiveReference & reference = primitiveReferences[i + lane];
+			if (!IsEnabled(reference)) {
+				continue;
+			}
+			intersectionRenderGroupIndex = reference.renderGroupIndex;
+			intersectionPrimitiveIndex = reference.primitiveIndex;
+			closestIntersectionDistance = intersectionDistances[lane];
+			hit = true;
+		}
+	}
+	return hit;
+}
+
+bool Accelerator::PrimitivesOcclude(const unsigned int first, const unsigned int count, const Ray & ray, const float tMax) const {
+	float intersectionDistances[PrimitiveBuffer::SIMD_WIDTH];
+	for (unsigned int i = first; i < first + count; i += PrimitiveBuffer::SIMD_WIDTH) {
+		const unsigned int width = std::min(PrimitiveBuffer::SIMD_WIDTH, first + count - i);
+		unsigned int mask = primitiveBuffer.RayIntersectionMask(i, width, ray, tMax, intersectionDistances);
+		for (unsigned int lane = 0; mask != 0; ++lane, mask >>= 1) {
+			if ((mask & 1) && IsEnabled(primitiveReferences[i + lane])) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,122 @@
+#include "AcceleratorBenchmark.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../Scene.h"
+
+namespace {
+	/// <summary> Generates random rays within the scene AABB. The same seed is used every time. </summary>
+	std::vector<Ray> GenerateRays(const Scene & scene, const unsigned int RAY_COUNT) {
+		std::default_random_engine generator(1337);
+		std::uniform_real_distribution<float> rand(0.0f, 1.0f);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+		const auto & aabb = scene.axisAlignedBoundingBox;
+		std::vector<Ray> rays(RAY_COUNT);
+		for (auto & ray : rays) {
+			const glm::vec3 t(rand(generator), rand(generator), rand(generator));
+			const glm::vec3 from = aabb.minimum + t * (aabb.maximum - aabb.minimum);
+			const glm::vec3 direction = glm::normalize(glm::vec3(normal(generator), normal(generator), normal(generator)));
+			ray = Ray(from, direction);
+		}
+		return rays;
+	}
+}
+
+void AcceleratorBenchmark::Run(Scene & scene, const AcceleratorType currentAcceleratorType, const unsigned int RAY_COUNT) {
+	std::cout << std::endl << "Benchmarking acceleration structures using " << RAY_COUNT << " rays ..." << std::endl;
+
+	// Generate the rays up front so that every structure gets the same rays.
+	const std::vector<Ray> rays = GenerateRays(scene, RAY_COUNT);
+
+	const AcceleratorType types[] = { AcceleratorType::BRUTE_FORCE, AcceleratorType::OCTREE, AcceleratorType::BOUNDING_VOLUME_HIERARCHY,
+									  AcceleratorType::TWO_LEVEL_BOUNDING_VOLUME_HIERARCHY };
+	for (const auto type : types) {
+		scene.SetAccelerator(type);
+
+		unsigned int hits = 0;
+		unsigned int intersectionRenderGroupIndex, intersectionPrimitiveIndex;
+		float intersectionDistance;
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		for (const auto & ray : rays) {
+			hits += scene.RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance) ? 1 : 0;
+		}
+		const auto took = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		std::cout << std::setw(40) << std::left << scene.accelerator->ACCELERATOR_NAME;
+		std::cout << std::setprecision(3) << std::fixed << (RAY_COUNT / std::max<double>(1.0, (double)took)) << " Mrays/s, ";
+		std::cout << hits << " hits." << std::endl;
+	}
+	std::cout << std::endl;
+
+	scene.SetAccelerator(currentAcceleratorType);
+}
+
+void AcceleratorBenchmark::RunIntersectionKernels(const Scene & scene, const unsigned int RAY_COUNT) {
+	PrimitiveBuffer primitiveBuffer;
+	for (const auto & renderGroup : scene.renderGroups) {
+		for (const auto * primitive : renderGroup.primitives) {
+			primitiveBuffer.Add(primitive);
+		}
+	}
+	const unsigned int size = primitiveBuffer.Size();
+	std::cout << "Benchmarking intersection kernels using " << RAY_COUNT << " rays and " << size << " primitives ..." << std::endl;
+
+	const std::vector<Ray> rays = GenerateRays(scene, RAY_COUNT);
+
+	typedef unsigned int (PrimitiveBuffer::*Kernel)(const unsigned int, const unsigned int, const Ray &, const float, float *) const;
+	struct KernelInfo {
+		std::string name;
+		Kernel kernel;
+		unsigned int width;
+	};
+	const KernelInfo kernels[] = {
+		{ "Scalar", &PrimitiveBuffer::RayIntersectionMaskScalar, 1 },
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 4
+		{ "SSE (4 wide)", &PrimitiveBuffer::RayIntersectionMaskSSE, 4 },
+#endif
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 8
+		{ "AVX (8 wide)", &PrimitiveBuffer::RayIntersectionMaskAVX, 8 },
+#endif
+	};
+
+	// The closest hit (entry index and distance) of every ray using the scalar kernel.
+	std::vector<std::pair<unsigned int, float>> scalarHits;
+	for (const auto & info : kernels) {
+		std::vector<std::pair<unsigned int, float>> hits(RAY_COUNT);
+		float intersectionDistances[8];
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		for (unsigned int r = 0; r < RAY_COUNT; ++r) {
+			const Ray & ray = rays[r];
+			std::pair<unsigned int, float> closest(size, ray.tMax);
+			for (unsigned int i = 0; i < size; i += info.width) {
+				unsigned int mask = (primitiveBuffer.*info.kernel)(i, std::min(info.width, size - i), ray, closest.second, intersectionDistances);
+				for (unsigned int lane = 0; mask != 0; ++lane, mask >>= 1) {
+					if ((mask & 1) && intersectionDistances[lane] < closest.second) {
+						closest = std::make_pair(i + lane, intersectionDistances[lane]);
+					}
+				}
+			}
+			hits[r] = closest;
+		}
+		const auto took = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		if (scalarHits.empty()) {
+			scalarHits = hits;
+		}
+		const auto mismatches = std::count_if(hits.begin(), hits.end(), [&](const std::pair<unsigned int, float> & hit) {
+			return hit != scalarHits[&hit - &hits[0]];
+		});
+		const auto hitCount = std::count_if(hits.begin(), hits.end(), [&](const std::pair<unsigned int, float> & hit) {
+			return hit.first != size;
+		});
+
+		std::cout << std::setw(40) << std::left << info.name;
+		std::cout << std::setprecision(3) << std::fixed << (RAY_COUNT / std::max<double>(1.0, (double)took)) << " Mrays/s, ";
+		std::cout << hitCount << " hits, " << mismatches << " mismatches." << std::endl;
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Accelerator.h"
+
+namespace AcceleratorBenchmark {
+	/// <summary> 
+	/// Casts the same set of random rays through the scene using every acceleration structure, and 
+	/// prints the build time and ray casting throughput (in million rays per second) of each structure.
+	/// The rays start at random positions within the scene AABB and have random directions.
+	/// The scene's current acceleration structure type is restored afterwards.
+	/// </summary>
+	/// <param name='scene'> An initialized scene. </param>
+	/// <param name='currentAcceleratorType'> The acceleration structure type to restore when finished. </param>
+	/// <param name='RAY_COUNT'> The number of rays to cast per acceleration structure. </param>
+	void Run(class Scene & scene, const AcceleratorType currentAcceleratorType, const unsigned int RAY_COUNT = 1000000);
+
+	/// <summary> 
+	/// Casts random rays through all primitives in the scene without any acceleration structure, using every available
+	/// primitive intersection kernel (scalar, SSE and AVX, see PrimitiveBuffer::RayIntersectionMask). Prints the throughput 
+	/// (in million rays per second) of each kernel, and the number of rays whose closest hit differs from the scalar kernel.
+	/// </summary>
+	/// <param name='scene'> An initialized scene. </param>
+	/// <param name='RAY_COUNT'> The number of rays to cast per kernel. </param>
+	void RunIntersectionKernels(const class Scene & scene, const unsigned int RAY_COUNT = 100000);
+}
@@ -0,0 +1,50 @@
+#include "BVHAccelerator.h"
+
+BVHAccelerator::BVHAccelerator(const Scene & _scene) :
+	Accelerator("Bounding Volume Hierarchy", _scene) { }
+
+void BVHAccelerator::BuildStructure(const std::vector<AABB> & primitiveBounds) {
+	boundingVolumeHierarchy.Build(primitiveBounds);
+
+	// Store the primitive references in leaf order, so that the primitives of every leaf can be intersected at once.
+	boundingVolumeHierarchy.ReorderItems(primitiveReferences);
+}
+
+bool BVHAccelerator::RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	float closestInterectionDistance = ray.tMax;
+	const bool hit = boundingVolumeHierarchy.Traverse(ray, closestInterectionDistance, [&](unsigned int first, unsigned int count, float & closestDistance) {
+		return IntersectPrimitives(first, count, ray, closestDistance, intersectionRenderGroupIndex, intersectionPrimitiveIndex);
+	});
+	intersectionDistance = hit ? closestInterectionDistance : FLT_MAX;
+	return hit;
+}
+
+bool BVHAccelerator::Occluded(const Ray & ray, const float tMax) const {
+	return boundingVolumeHierarchy.TraverseAny(ray, tMax, [&](unsigned int first, unsigned int count) {
+		return PrimitivesOcclude(first, count, ray, tMax);
+	});
+}
+
+void BVHAccelerator::RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const {
+	boundingVolumeHierarchy.TraverseAny(ray, ray.tMax, [&](unsigned int first, unsigned int count) {
+		for (unsigned int i = first; i < first + count; ++i) {
+			AppendPrimitiveIntersections(i, ray, intersections);
+		}
+		return false; // Keep traversing.
+	});
+}
+
+void BVHAccelerator::RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const {
+	float closestIntersectionDistances[MAX_PACKET_SIZE];
+	for (unsigned int i = 0; i < count; ++i) {
+		closestIntersectionDistances[i] = rays[i].tMax;
+	}
+	boundingVolumeHierarchy.TraversePacket(rays, count, closestIntersectionDistances, [&](unsigned int first, unsigned int itemCount, unsigned int firstRay) {
+		for (unsigned int i = firstRay; i < count; ++i) {
+			IntersectPrimitives(first, itemCount, rays[i], closestIntersectionDistances[i], intersections[i].renderGroupIndex, intersections[i].primitiveIndex);
+		}
+	});
+	for (unsigned int i = 0; i < count; ++i) {
+		intersections[i].distance = closestIntersectionDistances[i] < rays[i].tMax ? closestIntersectionDistances[i] : FLT_MAX;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Accelerator.h"
+#include "../BoundingVolumeHierarchy.h"
+
+/// <summary> 
+/// Acceleration structure using a binned SAH bounding volume hierarchy over all primitives.
+/// Works well for most scenes, especially scenes with many small primitives.
+/// </summary>
+class BVHAccelerator : public Accelerator {
+public:
+	BVHAccelerator(const class Scene & scene);
+	bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const override;
+	bool Occluded(const Ray & ray, const float tMax) const override;
+	void RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const override;
+	void RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const override;
+protected:
+	void BuildStructure(const std::vector<AABB> & primitiveBounds) override;
+private:
+	BoundingVolumeHierarchy boundingVolumeHierarchy;
+};
@@ -0,0 +1,24 @@
+#include "BruteForceAccelerator.h"
+
+BruteForceAccelerator::BruteForceAccelerator(const Scene & _scene) :
+	Accelerator("Brute Force", _scene) { }
+
+void BruteForceAccelerator::BuildStructure(const std::vector<AABB> &) { }
+
+bool BruteForceAccelerator::RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	float closestInterectionDistance = ray.tMax;
+	const bool hit = IntersectPrimitives(0, static_cast<unsigned int>(primitiveReferences.size()), ray, closestInterectionDistance,
+										 intersectionRenderGroupIndex, intersectionPrimitiveIndex);
+	intersectionDistance = hit ? closestInterectionDistance : FLT_MAX;
+	return hit;
+}
+
+bool BruteForceAccelerator::Occluded(const Ray & ray, const float tMax) const {
+	return PrimitivesOcclude(0, static_cast<unsigned int>(primitiveReferences.size()), ray, tMax);
+}
+
+void BruteForceAccelerator::RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const {
+	for (unsigned int i = 0; i < primitiveReferences.size(); ++i) {
+		AppendPrimitiveIntersections(i, ray, intersections);
+	}
+}
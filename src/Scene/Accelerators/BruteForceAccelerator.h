@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Accelerator.h"
+
+/// <summary> 
+/// Reference "acceleration structure" which tests every primitive in the scene for every ray.
+/// </summary>
+class BruteForceAccelerator : public Accelerator {
+public:
+	BruteForceAccelerator(const class Scene & scene);
+	bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const override;
+	bool Occluded(const Ray & ray, const float tMax) const override;
+	void RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const override;
+protected:
+	void BuildStructure(const std::vector<AABB> & primitiveBounds) override;
+};
@@ -0,0 +1,212 @@
+#include "OctreeAccelerator.h"
+
+#include <algorithm>
+
+#define __OCTREE_MAX_DEPTH 8 // The maximum depth of the octree.
+#define __OCTREE_MAX_LEAF_SIZE 8 // Nodes containing more primitives than this are subdivided.
+
+namespace {
+	// Returns true if two AABBs overlap (touching counts as overlapping).
+	bool Overlaps(const AABB & a, const AABB & b) {
+		return a.minimum.x <= b.maximum.x && a.maximum.x >= b.minimum.x &&
+			a.minimum.y <= b.maximum.y && a.maximum.y >= b.minimum.y &&
+			a.minimum.z <= b.maximum.z && a.maximum.z >= b.minimum.z;
+	}
+}
+
+OctreeAccelerator::OctreeAccelerator(const Scene & _scene) :
+	Accelerator("Octree", _scene) { }
+
+void OctreeAccelerator::BuildStructure(const std::vector<AABB> & primitiveBounds) {
+	nodes.clear();
+	itemIndices.clear();
+	if (primitiveBounds.empty()) {
+		return;
+	}
+
+	// The root is the smallest cube containing all primitives.
+	glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+	for (const auto & aabb : primitiveBounds) {
+		minimum = glm::min(minimum, aabb.minimum);
+		maximum = glm::max(maximum, aabb.maximum);
+	}
+	const glm::vec3 center = 0.5f * (minimum + maximum);
+	const glm::vec3 extent = maximum - minimum;
+	const float halfSize = 0.5f * glm::max(extent.x, glm::max(extent.y, extent.z)) + FLT_EPSILON;
+
+	std::vector<unsigned int> items(primitiveBounds.size());
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		items[i] = i;
+	}
+
+	nodes.push_back({ AABB(center - glm::vec3(halfSize), center + glm::vec3(halfSize)), 0, 0, 0 });
+	Subdivide(0, primitiveBounds, items, 0);
+}
+
+void OctreeAccelerator::Subdivide(const unsigned int nodeIndex, const std::vector<AABB> & primitiveBounds,
+								  const std::vector<unsigned int> & items, const unsigned int depth) {
+	const AABB cube = nodes[nodeIndex].axisAlignedBoundingBox;
+
+	// Distribute the items among the children.
+	std::vector<unsigned int> childItems[8];
+	AABB childCubes[8];
+	bool improves = false;
+	if (items.size() > __OCTREE_MAX_LEAF_SIZE && depth < __OCTREE_MAX_DEPTH) {
+		const glm::vec3 center = cube.GetCenter();
+		for (unsigned int c = 0; c < 8; ++c) {
+			// Bit 0, 1 and 2 of the child index decides which half along x, y and z the child is in.
+			glm::vec3 childMinimum, childMaximum;
+			for (int axis = 0; axis < 3; ++axis) {
+				const bool upper = (c >> axis) & 1;
+				childMinimum[axis] = upper ? center[axis] : cube.minimum[axis];
+				childMaximum[axis] = upper ? cube.maximum[axis] : center[axis];
+			}
+			childCubes[c] = AABB(childMinimum, childMaximum);
+			for (const unsigned int item : items) {
+				if (Overlaps(childCubes[c], primitiveBounds[item])) {
+					childItems[c].push_back(item);
+				}
+			}
+			improves |= childItems[c].size() < items.size();
+		}
+	}
+
+	// Create a leaf if the node is small enough, or if subdividing doesn't separate the primitives.
+	if (!improves) {
+		nodes[nodeIndex].offset = static_cast<unsigned int>(itemIndices.size());
+		nodes[nodeIndex].count = static_cast<unsigned int>(items.size());
+		itemIndices.insert(itemIndices.end(), items.begin(), items.end());
+		return;
+	}
+
+	// The eight children are stored contiguously.
+	const unsigned int firstChild = static_cast<unsigned int>(nodes.size());
+	nodes[nodeIndex].firstChild = firstChild;
+	for (unsigned int c = 0; c < 8; ++c) {
+		nodes.push_back({ childCubes[c], 0, 0, 0 });
+	}
+	for (unsigned int c = 0; c < 8; ++c) {
+		Subdivide(firstChild + c, primitiveBounds, childItems[c], depth + 1);
+	}
+}
+
+bool OctreeAccelerator::RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	float closestInterectionDistance = ray.tMax;
+	bool hit = false;
+	intersectionDistance = FLT_MAX;
+
+	float entryDistance;
+	if (nodes.empty() || !nodes[0].axisAlignedBoundingBox.RayIntersection(ray, closestInterectionDistance, entryDistance)) {
+		return false;
+	}
+
+	// Traverse the octree front to back using a stack of (node, entry distance) pairs.
+	// Since primitives can be referenced by several nodes, a hit found in one node might be behind
+	// another node. Nodes are therefore only skipped once they are entered behind the closest hit.
+	std::pair<unsigned int, float> stack[8 * __OCTREE_MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = std::make_pair(0u, entryDistance);
+
+	while (stackSize > 0) {
+		const auto entry = stack[--stackSize];
+		if (entry.second > closestInterectionDistance) {
+			continue;
+		}
+		const Node & node = nodes[entry.first];
+		if (node.IsLeaf()) {
+			for (unsigned int i = node.offset; i < node.offset + node.count; ++i) {
+				hit |= IntersectPrimitive(itemIndices[i], ray, closestInterectionDistance, intersectionRenderGroupIndex, intersectionPrimitiveIndex);
+			}
+			continue;
+		}
+
+		// Find the children that are hit by the ray and sort them by entry distance (furthest first).
+		std::pair<unsigned int, float> hitChildren[8];
+		unsigned int hitCount = 0;
+		for (unsigned int c = 0; c < 8; ++c) {
+			const unsigned int child = node.firstChild + c;
+			if (nodes[child].IsLeaf() && nodes[child].count == 0) {
+				continue; // Empty leaf.
+			}
+			if (nodes[child].axisAlignedBoundingBox.RayIntersection(ray, closestInterectionDistance, entryDistance)) {
+				hitChildren[hitCount++] = std::make_pair(child, entryDistance);
+			}
+		}
+		std::sort(hitChildren, hitChildren + hitCount, [](const std::pair<unsigned int, float> & a, const std::pair<unsigned int, float> & b) {
+			return a.second > b.second;
+		});
+
+		// Push the children so that the closest child is popped first.
+		for (unsigned int i = 0; i < hitCount; ++i) {
+			stack[stackSize++] = hitChildren[i];
+		}
+	}
+
+	intersectionDistance = hit ? closestInterectionDistance : FLT_MAX;
+	return hit;
+}
+
+bool OctreeAccelerator::Occluded(const Ray & ray, const float tMax) const {
+	float entryDistance;
+	if (nodes.empty() || !nodes[0].axisAlignedBoundingBox.RayIntersection(ray, tMax, entryDistance)) {
+		return false;
+	}
+
+	// Any hit will do, so the children are visited in whatever order they are stored in.
+	unsigned int stack[8 * __OCTREE_MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const Node & node = nodes[stack[--stackSize]];
+		if (node.IsLeaf()) {
+			for (unsigned int i = node.offset; i < node.offset + node.count; ++i) {
+				if (PrimitiveOccludes(itemIndices[i], ray, tMax)) {
+					return true;
+				}
+			}
+			continue;
+		}
+		for (unsigned int c = 0; c < 8; ++c) {
+			const unsigned int child = node.firstChild + c;
+			if (nodes[child].IsLeaf() && nodes[child].count == 0) {
+				continue; // Empty leaf.
+			}
+			if (nodes[child].axisAlignedBoundingBox.RayIntersection(ray, tMax, entryDistance)) {
+				stack[stackSize++] = child;
+			}
+		}
+	}
+	return false;
+}
+
+void OctreeAccelerator::RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const {
+	float entryDistance;
+	if (nodes.empty() || !nodes[0].axisAlignedBoundingBox.RayIntersection(ray, ray.tMax, entryDistance)) {
+		return;
+	}
+
+	// Primitives referenced by several leaves are reported once per leaf. Scene::RayCastAll removes the duplicates.
+	unsigned int stack[8 * __OCTREE_MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const Node & node = nodes[stack[--stackSize]];
+		if (node.IsLeaf()) {
+			for (unsigned int i = node.offset; i < node.offset + node.count; ++i) {
+				AppendPrimitiveIntersections(itemIndices[i], ray, intersections);
+			}
+			continue;
+		}
+		for (unsigned int c = 0; c < 8; ++c) {
+			const unsigned int child = node.firstChild + c;
+			if (nodes[child].IsLeaf() && nodes[child].count == 0) {
+				continue; // Empty leaf.
+			}
+			if (nodes[child].axisAlignedBoundingBox.RayIntersection(ray, ray.tMax, entryDistance)) {
+				stack[stackSize++] = child;
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Accelerator.h"
+
+/// <summary> 
+/// Acceleration structure using an octree. The scene is recursively split into eight equally 
+/// sized cubes. Primitives overlapping several cubes are referenced by all of them.
+/// Works well for scenes with a few large primitives (e.g. spheres) which are spread out evenly.
+/// </summary>
+class OctreeAccelerator : public Accelerator {
+public:
+	OctreeAccelerator(const class Scene & scene);
+	bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const override;
+	bool Occluded(const Ray & ray, const float tMax) const override;
+	void RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const override;
+protected:
+	void BuildStructure(const std::vector<AABB> & primitiveBounds) override;
+private:
+	/// <summary> A node (cube) in the octree. </summary>
+	struct Node {
+		AABB axisAlignedBoundingBox;
+
+		/// <summary> Index of the first of the eight children. Zero for leaves. </summary>
+		unsigned int firstChild;
+
+		/// <summary> The range of primitive reference indices in the item index vector (only used by leaves). </summary>
+		unsigned int offset, count;
+
+		bool IsLeaf() const { return firstChild == 0; }
+	};
+
+	std::vector<Node> nodes;
+	std::vector<unsigned int> itemIndices;
+
+	/// <summary> Recursively subdivides the given node. </summary>
+	void Subdivide(const unsigned int nodeIndex, const std::vector<AABB> & primitiveBounds,
+				   const std::vector<unsigned int> & items, const unsigned int depth);
+};
@@ -0,0 +1,276 @@
+#include "PrimitiveBuffer.h"
+
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH > 1
+#include <immintrin.h>
+#endif
+
+#include "../../Geometry/Triangle.h"
+#include "../../Geometry/Sphere.h"
+
+namespace {
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 4
+	/// <summary> Thin wrappers around the SSE intrinsics, so that the same kernels can be compiled for several widths. </summary>
+	struct SSE {
+		typedef __m128 Float;
+		static const unsigned int WIDTH = 4;
+		static Float Set(const float a) { return _mm_set1_ps(a); }
+		static Float Load(const float * a) { return _mm_loadu_ps(a); }
+		static void Store(float * a, const Float b) { _mm_storeu_ps(a, b); }
+		static Float Add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+		static Float Sub(const Float a, const Float b) { return _mm_sub_ps(a, b); }
+		static Float Mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+		static Float Div(const Float a, const Float b) { return _mm_div_ps(a, b); }
+		static Float Sqrt(const Float a) { return _mm_sqrt_ps(a); }
+		static Float Min(const Float a, const Float b) { return _mm_min_ps(a, b); } // a < b ? a : b, like glm::min.
+		static Float Less(const Float a, const Float b) { return _mm_cmplt_ps(a, b); }
+		static Float And(const Float a, const Float b) { return _mm_and_ps(a, b); }
+		static Float Or(const Float a, const Float b) { return _mm_or_ps(a, b); }
+		static Float AndNot(const Float a, const Float b) { return _mm_andnot_ps(b, a); } // a & ~b.
+		static unsigned int Mask(const Float a) { return static_cast<unsigned int>(_mm_movemask_ps(a)); }
+	};
+#endif
+
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 8
+	/// <summary> Thin wrappers around the AVX intrinsics. See SSE. </summary>
+	struct AVX {
+		typedef __m256 Float;
+		static const unsigned int WIDTH = 8;
+		static Float Set(const float a) { return _mm256_set1_ps(a); }
+		static Float Load(const float * a) { return _mm256_loadu_ps(a); }
+		static void Store(float * a, const Float b) { _mm256_storeu_ps(a, b); }
+		static Float Add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+		static Float Sub(const Float a, const Float b) { return _mm256_sub_ps(a, b); }
+		static Float Mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+		static Float Div(const Float a, const Float b) { return _mm256_div_ps(a, b); }
+		static Float Sqrt(const Float a) { return _mm256_sqrt_ps(a); }
+		static Float Min(const Float a, const Float b) { return _mm256_min_ps(a, b); }
+		static Float Less(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static Float And(const Float a, const Float b) { return _mm256_and_ps(a, b); }
+		static Float Or(const Float a, const Float b) { return _mm256_or_ps(a, b); }
+		static Float AndNot(const Float a, const Float b) { return _mm256_andnot_ps(b, a); }
+		static unsigned int Mask(const Float a) { return static_cast<unsigned int>(_mm256_movemask_ps(a)); }
+	};
+#endif
+
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH > 1
+	template<typename S>
+	inline typename S::Float Dot(const typename S::Float ax, const typename S::Float ay, const typename S::Float az,
+								 const typename S::Float bx, const typename S::Float by, const typename S::Float bz) {
+		return S::Add(S::Add(S::Mul(ax, bx), S::Mul(ay, by)), S::Mul(az, bz));
+	}
+
+	/// <summary>
+	/// Moller-Trumbore intersection between a ray and S::WIDTH triangles. Performs the same operations in the same 
+	/// order as PrimitiveBuffer::RayTriangleIntersection, so the results are identical. Returns a mask of the hits.
+	/// </summary>
+	template<typename S>
+	inline unsigned int RayTriangleIntersections(const std::vector<float> * components, const unsigned int first, const Ray & ray, 
+												 const float maxDistance, float * intersectionDistances) {
+		typedef typename S::Float F;
+		const F dx = S::Set(ray.direction.x), dy = S::Set(ray.direction.y), dz = S::Set(ray.direction.z);
+		const F v0x = S::Load(&components[0][first]), v0y = S::Load(&components[1][first]), v0z = S::Load(&components[2][first]);
+		const F e1x = S::Load(&components[3][first]), e1y = S::Load(&components[4][first]), e1z = S::Load(&components[5][first]);
+		const F e2x = S::Load(&components[6][first]), e2y = S::Load(&components[7][first]), e2z = S::Load(&components[8][first]);
+		const F zero = S::Set(0.0f), one = S::Set(1.0f);
+
+		// P = cross(direction, e2), T = from - v0.
+		const F px = S::Sub(S::Mul(dy, e2z), S::Mul(e2y, dz));
+		const F py = S::Sub(S::Mul(dz, e2x), S::Mul(e2z, dx));
+		const F pz = S::Sub(S::Mul(dx, e2y), S::Mul(e2x, dy));
+		const F tx = S::Sub(S::Set(ray.from.x), v0x), ty = S::Sub(S::Set(ray.from.y), v0y), tz = S::Sub(S::Set(ray.from.z), v0z);
+
+		const F inv_den = S::Div(one, Dot<S>(e1x, e1y, e1z, px, py, pz));
+
+		const F u = S::Mul(inv_den, Dot<S>(tx, ty, tz, px, py, pz));
+		F miss = S::Or(S::Less(u, zero), S::Less(one, u));
+
+		// Q = cross(T, e1).
+		const F qx = S::Sub(S::Mul(ty, e1z), S::Mul(e1y, tz));
+		const F qy = S::Sub(S::Mul(tz, e1x), S::Mul(e1z, tx));
+		const F qz = S::Sub(S::Mul(tx, e1y), S::Mul(e1x, ty));
+		const F v = S::Mul(inv_den, Dot<S>(dx, dy, dz, qx, qy, qz));
+		miss = S::Or(miss, S::Or(S::Less(v, zero), S::Less(one, S::Add(u, v))));
+
+		const F t = S::Mul(inv_den, Dot<S>(e2x, e2y, e2z, qx, qy, qz));
+		S::Store(intersectionDistances, t);
+		return S::Mask(S::AndNot(S::And(S::Less(S::Set(ray.tMin), t), S::Less(t, S::Set(maxDistance))), miss));
+	}
+
+	/// <summary>
+	/// Intersection between a ray and S::WIDTH spheres. Performs the same operations in the same order as 
+	/// PrimitiveBuffer::RaySphereIntersection, so the results are identical. Returns a mask of the hits.
+	/// </summary>
+	template<typename S>
+	inline unsigned int RaySphereIntersections(const std::vector<float> * components, const unsigned int first, const Ray & ray, 
+											   const float maxDistance, float * intersectionDistances) {
+		typedef typename S::Float F;
+		const F dx = S::Set(ray.direction.x), dy = S::Set(ray.direction.y), dz = S::Set(ray.direction.z);
+		const F mx = S::Sub(S::Set(ray.from.x), S::Load(&components[0][first]));
+		const F my = S::Sub(S::Set(ray.from.y), S::Load(&components[1][first]));
+		const F mz = S::Sub(S::Set(ray.from.z), S::Load(&components[2][first]));
+		const F tMin = S::Set(ray.tMin);
+
+		const F u = S::Mul(S::Set(2.0f), Dot<S>(mx, my, mz, dx, dy, dz));
+		const F v = S::Sub(Dot<S>(mx, my, mz, mx, my, mz), S::Load(&components[3][first]));
+		F d = S::Sub(S::Mul(S::Mul(S::Set(0.25f), u), u), v);
+		const F miss = S::Less(d, S::Set(FLT_EPSILON));
+		d = S::Sqrt(d);
+
+		const F halfU = S::Mul(S::Set(-0.5f), u);
+		F t1 = S::Add(halfU, d);
+		F t2 = S::Sub(halfU, d);
+		F mask = S::Less(t1, tMin);
+		t1 = S::Or(S::And(mask, t2), S::AndNot(t1, mask));
+		mask = S::Less(t2, tMin);
+		t2 = S::Or(S::And(mask, t1), S::AndNot(t2, mask));
+		const F t = S::Min(t1, t2);
+		S::Store(intersectionDistances, t);
+		return S::Mask(S::AndNot(S::And(S::Less(tMin, t), S::Less(t, S::Set(maxDistance))), miss));
+	}
+#endif
+}
+
+void PrimitiveBuffer::Clear() {
+	triangles.clear();
+	spheres.clear();
+	otherPrimitives.clear();
+	entries.clear();
+	for (auto & components : triangleComponents) { components.clear(); }
+	for (auto & components : sphereComponents) { components.clear(); }
+}
+
+void PrimitiveBuffer::Add(const Primitive * primitive) {
+	if (const Triangle * triangle = dynamic_cast<const Triangle*>(primitive)) {
+		const auto & vertices = triangle->vertices;
+		entries.push_back(TRIANGLE | static_cast<unsigned int>(triangles.size()));
+		triangles.push_back({ vertices[0], vertices[1] - vertices[0], vertices[2] - vertices[0] });
+	}
+	else if (const Sphere * sphere = dynamic_cast<const Sphere*>(primitive)) {
+		entries.push_back(SPHERE | static_cast<unsigned int>(spheres.size()));
+		spheres.push_back({ sphere->center, sphere->radius * sphere->radius });
+	}
+	else {
+		entries.push_back(OTHER | static_cast<unsigned int>(otherPrimitives.size()));
+		otherPrimitives.push_back(primitive);
+	}
+
+	// Keep the structure of arrays copies padded with zeros.
+	const unsigned int index = Size() - 1;
+	for (auto & components : triangleComponents) { components.resize(index + SIMD_WIDTH, 0.0f); }
+	for (auto & components : sphereComponents) { components.resize(index + SIMD_WIDTH, 0.0f); }
+	const unsigned int entry = entries[index];
+	if ((entry & TYPE_MASK) == TRIANGLE) {
+		const TriangleData & triangle = triangles[entry & ~TYPE_MASK];
+		for (unsigned int i = 0; i < 3; ++i) {
+			triangleComponents[i][index] = triangle.v0[i];
+			triangleComponents[3 + i][index] = triangle.e1[i];
+			triangleComponents[6 + i][index] = triangle.e2[i];
+		}
+	}
+	else if ((entry & TYPE_MASK) == SPHERE) {
+		const SphereData & sphere = spheres[entry & ~TYPE_MASK];
+		for (unsigned int i = 0; i < 3; ++i) {
+			sphereComponents[i][index] = sphere.center[i];
+		}
+		sphereComponents[3][index] = sphere.radiusSquared;
+	}
+}
+
+void PrimitiveBuffer::GetTypeMasks(const unsigned int first, const unsigned int count, unsigned int & triangleMask, unsigned int & sphereMask, unsigned int & otherMask) const {
+	triangleMask = sphereMask = otherMask = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		switch (entries[first + i] & TYPE_MASK) {
+		case TRIANGLE: triangleMask |= 1u << i; break;
+		case SPHERE: sphereMask |= 1u << i; break;
+		default: otherMask |= 1u << i; break;
+		}
+	}
+}
+
+unsigned int PrimitiveBuffer::RayIntersectionMaskScalar(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+														float * intersectionDistances) const {
+	unsigned int mask = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		if (RayIntersection(first + i, ray, intersectionDistances[i]) && intersectionDistances[i] < maxDistance) {
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH > 1
+template<typename InstructionSet>
+unsigned int PrimitiveBuffer::RayIntersectionMaskSIMD(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+													  float * intersectionDistances) const {
+	unsigned int triangleMask, sphereMask, otherMask;
+	GetTypeMasks(first, count, triangleMask, sphereMask, otherMask);
+
+	// Only run the kernels for the types present in the range, and only keep the lanes of the right type.
+	unsigned int mask = 0;
+	if (triangleMask != 0) {
+		mask |= triangleMask & RayTriangleIntersections<InstructionSet>(triangleComponents, first, ray, maxDistance, intersectionDistances);
+	}
+	if (sphereMask != 0) {
+		float sphereIntersectionDistances[InstructionSet::WIDTH];
+		const unsigned int sphereHits = sphereMask & RaySphereIntersections<InstructionSet>(sphereComponents, first, ray, maxDistance, sphereIntersectionDistances);
+		for (unsigned int i = 0; i < count; ++i) {
+			if (sphereMask & (1u << i)) {
+				intersectionDistances[i] = sphereIntersectionDistances[i];
+			}
+		}
+		mask |= sphereHits;
+	}
+	for (unsigned int i = 0; i < count && otherMask != 0; ++i) {
+		if ((otherMask & (1u << i)) && RayIntersection(first + i, ray, intersectionDistances[i]) && intersectionDistances[i] < maxDistance) {
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+#endif
+
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 4
+unsigned int PrimitiveBuffer::RayIntersectionMaskSSE(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+													 float * intersectionDistances) const {
+	return RayIntersectionMaskSIMD<SSE>(first, count, ray, maxDistance, intersectionDistances);
+}
+#endif
+
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 8
+unsigned int PrimitiveBuffer::RayIntersectionMaskAVX(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+													 float * intersectionDistances) const {
+	return RayIntersectionMaskSIMD<AVX>(first, count, ray, maxDistance, intersectionDistances);
+}
+#endif
+
+unsigned int PrimitiveBuffer::RayIntersections(const unsigned int entryIndex, const Ray & ray, float intersectionDistances[Primitive::MAX_RAY_INTERSECTIONS]) const {
+	const unsigned int entry = entries[entryIndex];
+	const unsigned int index = entry & ~TYPE_MASK;
+	switch (entry & TYPE_MASK) {
+	case TRIANGLE:
+		return RayTriangleIntersection(triangles[index], ray, intersectionDistances[0]) ? 1 : 0;
+	case SPHERE:
+	{
+		// Both the entry and the exit point.
+		const SphereData & sphere = spheres[index];
+		const glm::vec3 m = ray.from - sphere.center;
+		const float u = 2 * glm::dot(m, ray.direction);
+		const float v = glm::dot(m, m) - sphere.radiusSquared;
+		float d = 0.25f * u * u - v;
+		if (d < FLT_EPSILON) {
+			return 0;
+		}
+		d = sqrt(d);
+		const float t[2] = { -0.5f * u - d, -0.5f * u + d };
+		unsigned int count = 0;
+		for (const float ti : t) {
+			if (ti > ray.tMin && ti < ray.tMax) {
+				intersectionDistances[count++] = ti;
+			}
+		}
+		return count;
+	}
+	default:
+		return otherPrimitives[index]->RayIntersections(ray, intersectionDistances);
+	}
+}
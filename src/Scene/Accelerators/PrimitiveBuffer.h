@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+
+#include <glm.hpp>
+
+#include "../../Geometry/Ray.h"
+#include "../../Geometry/Primitive.h"
+
+#define __PRIMITIVE_BUFFER_USE_SIMD true // Use SSE/AVX kernels that intersect several primitives at once.
+
+// The widest kernel available given the instruction sets enabled at compile time (e.g. /arch:AVX2 enables AVX).
+#if __PRIMITIVE_BUFFER_USE_SIMD && defined(__AVX__)
+#define __PRIMITIVE_BUFFER_SIMD_WIDTH 8
+#elif __PRIMITIVE_BUFFER_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define __PRIMITIVE_BUFFER_SIMD_WIDTH 4
+#else
+#define __PRIMITIVE_BUFFER_SIMD_WIDTH 1
+#endif
+
+/// <summary>
+/// A compact copy of the geometry of the primitives used by an acceleration structure.
+/// Triangles and spheres are stored by value in contiguous typed arrays, so that intersection
+/// tests neither chase pointers nor call virtual functions. Entries are referenced by index.
+/// Primitives of any other type fall back to the virtual Primitive::RayIntersection.
+/// Consecutive entries can also be tested at once using SSE (4 wide) or AVX (8 wide) kernels.
+/// </summary>
+class PrimitiveBuffer {
+public:
+	/// <summary> A triangle with precomputed edges for the Moller-Trumbore intersection test. </summary>
+	struct TriangleData {
+		glm::vec3 v0, e1, e2; // e1 = v1 - v0, e2 = v2 - v0.
+	};
+
+	/// <summary> A sphere with its squared radius. </summary>
+	struct SphereData {
+		glm::vec3 center;
+		float radiusSquared;
+	};
+
+	std::vector<TriangleData> triangles;
+	std::vector<SphereData> spheres;
+	std::vector<const Primitive*> otherPrimitives;
+
+	/// <summary> Removes all entries. </summary>
+	void Clear();
+
+	/// <summary> Adds a copy of the geometry of a primitive. The entry index is the number of entries added before it. </summary>
+	void Add(const Primitive * primitive);
+
+	/// <summary> Returns the number of entries. </summary>
+	unsigned int Size() const { return static_cast<unsigned int>(entries.size()); }
+
+	/// <summary>
+	/// Computes the closest intersection between a ray and an entry within (ray.tMin, ray.tMax).
+	/// Gives the same result as Primitive::RayIntersection. Returns true if there is an intersection.
+	/// </summary>
+	inline bool RayIntersection(const unsigned int entryIndex, const Ray & ray, float & intersectionDistance) const;
+
+	/// <summary> The number of consecutive entries tested at once by RayIntersectionMask. </summary>
+	static const unsigned int SIMD_WIDTH = __PRIMITIVE_BUFFER_SIMD_WIDTH;
+
+	/// <summary>
+	/// Intersects a ray with the consecutive entries [first, first + count), where count is at most SIMD_WIDTH,
+	/// using the widest kernel available. Returns a bit mask where bit i is set if entry first + i is hit within 
+	/// (ray.tMin, maxDistance). Gives the same result as calling RayIntersection for every entry.
+	/// </summary>
+	/// <param name='maxDistance'> Hits at or beyond this distance are ignored. Must not be larger than ray.tMax. </param>
+	/// <param name='intersectionDistances'> OUT: The distance to every hit entry (entry first + i is stored at index i). </param>
+	inline unsigned int RayIntersectionMask(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+											float intersectionDistances[SIMD_WIDTH]) const;
+
+	/// <summary> See RayIntersectionMask. Tests the entries one by one (count is at most 32). </summary>
+	unsigned int RayIntersectionMaskScalar(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+										   float * intersectionDistances) const;
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 4
+	/// <summary> See RayIntersectionMask. Tests up to 4 entries at once using SSE. </summary>
+	unsigned int RayIntersectionMaskSSE(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+										float * intersectionDistances) const;
+#endif
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH >= 8
+	/// <summary> See RayIntersectionMask. Tests up to 8 entries at once using AVX. </summary>
+	unsigned int RayIntersectionMaskAVX(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+										float * intersectionDistances) const;
+#endif
+
+	/// <summary> Computes all intersections between a ray and an entry. See Primitive::RayIntersections. </summary>
+	unsigned int RayIntersections(const unsigned int entryIndex, const Ray & ray, float intersectionDistances[Primitive::MAX_RAY_INTERSECTIONS]) const;
+
+	/// <summary> Moller-Trumbore ray triangle intersection. See Triangle::RayIntersection. </summary>
+	static inline bool RayTriangleIntersection(const TriangleData & triangle, const Ray & ray, float & intersectionDistance);
+
+	/// <summary> Ray sphere intersection. See Sphere::RayIntersection. </summary>
+	static inline bool RaySphereIntersection(const SphereData & sphere, const Ray & ray, float & intersectionDistance);
+
+private:
+	/// <summary> The type of every entry is stored in the two highest bits of the entry. </summary>
+	enum EntryType : unsigned int {
+		TRIANGLE = 0u << 30, SPHERE = 1u << 30, OTHER = 2u << 30
+	};
+	static const unsigned int TYPE_MASK = 3u << 30;
+
+	/// <summary> The type and typed array index of every entry. </summary>
+	std::vector<unsigned int> entries;
+
+	/// <summary>
+	/// Structure of arrays copies of the triangles (v0, e1, e2) and spheres (center, radiusSquared) used by the SIMD kernels.
+	/// Component c of entry i is stored at index i of array c. Entries of other types store zeros.
+	/// The arrays are padded so that SIMD_WIDTH consecutive components can always be loaded.
+	/// </summary>
+	std::vector<float> triangleComponents[9], sphereComponents[4];
+
+	/// <summary> Computes bit masks of the triangle, sphere and other entries in [first, first + count). </summary>
+	void GetTypeMasks(const unsigned int first, const unsigned int count, unsigned int & triangleMask, unsigned int & sphereMask, unsigned int & otherMask) const;
+
+	/// <summary> See RayIntersectionMask. Runs the kernels for the given (SSE or AVX) instruction set. </summary>
+	template<typename InstructionSet>
+	unsigned int RayIntersectionMaskSIMD(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+										 float * intersectionDistances) const;
+};
+
+unsigned int PrimitiveBuffer::RayIntersectionMask(const unsigned int first, const unsigned int count, const Ray & ray, const float maxDistance,
+												  float intersectionDistances[SIMD_WIDTH]) const {
+#if __PRIMITIVE_BUFFER_SIMD_WIDTH == 8
+	return RayIntersectionMaskAVX(first, count, ray, maxDistance, intersectionDistances);
+#elif __PRIMITIVE_BUFFER_SIMD_WIDTH == 4
+	return RayIntersectionMaskSSE(first, count, ray, maxDistance, intersectionDistances);
+#else
+	return RayIntersectionMaskScalar(first, count, ray, maxDistance, intersectionDistances);
+#endif
+}
+
+bool PrimitiveBuffer::RayIntersection(const unsigned int entryIndex, const Ray & ray, float & intersectionDistance) const {
+	const unsigned int entry = entries[entryIndex];
+	const unsigned int index = entry & ~TYPE_MASK;
+	switch (entry & TYPE_MASK) {
+	case TRIANGLE:
+		return RayTriangleIntersection(triangles[index], ray, intersectionDistance);
+	case SPHERE:
+		return RaySphereIntersection(spheres[index], ray, intersectionDistance);
+	default:
+		return otherPrimitives[index]->RayIntersection(ray, intersectionDistance);
+	}
+}
+
+bool PrimitiveBuffer::RayTriangleIntersection(const TriangleData & triangle, const Ray & ray, float & intersectionDistance) {
+	const glm::vec3 P = glm::cross(ray.direction, triangle.e2);
+	const glm::vec3 T = ray.from - triangle.v0;
+
+	const float inv_den = 1.0f / glm::dot(triangle.e1, P);
+
+	const float u = inv_den * glm::dot(T, P);
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+
+	const glm::vec3 Q = glm::cross(T, triangle.e1);
+	const float v = inv_den * glm::dot(ray.direction, Q);
+	if (v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+
+	intersectionDistance = inv_den * glm::dot(triangle.e2, Q);
+	return intersectionDistance > ray.tMin && intersectionDistance < ray.tMax;
+}
+
+bool PrimitiveBuffer::RaySphereIntersection(const SphereData & sphere, const Ray & ray, float & intersectionDistance) {
+	const glm::vec3 m = ray.from - sphere.center;
+	const float u = 2 * glm::dot(m, ray.direction);
+	const float v = glm::dot(m, m) - sphere.radiusSquared;
+	float d = 0.25f * u * u - v;
+	if (d < FLT_EPSILON) {
+		return false;
+	}
+	d = sqrt(d);
+	float t1 = -0.5f * u + d;
+	float t2 = -0.5f * u - d;
+	if (t1 < ray.tMin) { t1 = t2; }
+	if (t2 < ray.tMin) { t2 = t1; }
+	intersectionDistance = glm::min<float>(t1, t2);
+	return intersectionDistance > ray.tMin && intersectionDistance < ray.tMax;
+}
@@ -0,0 +1,176 @@
+#include "TwoLevelBVHAccelerator.h"
+
+#include <cassert>
+
+#include "../Scene.h"
+
+TwoLevelBVHAccelerator::TwoLevelBVHAccelerator(const Scene & _scene) :
+	Accelerator("Two Level Bounding Volume Hierarchy", _scene) { }
+
+void TwoLevelBVHAccelerator::BuildStructure(const std::vector<AABB> & primitiveBounds) {
+	// The primitive references are collected render group by render group (see Accelerator::Build).
+	bottomLevelHierarchies.clear();
+	renderGroupReferenceOffsets.clear();
+	unsigned int offset = 0;
+	for (unsigned int i = 0; i < scene.renderGroups.size(); ++i) {
+		const unsigned int count = static_cast<unsigned int>(scene.renderGroups[i].primitives.size());
+		renderGroupReferenceOffsets.push_back(offset);
+		BuildBottomLevel(std::vector<AABB>(primitiveBounds.begin() + offset, primitiveBounds.begin() + offset + count));
+		bottomLevelHierarchies.back().ReorderItems(primitiveReferences, offset);
+		offset += count;
+	}
+	BuildTopLevel();
+}
+
+void TwoLevelBVHAccelerator::UpdateRenderGroups() {
+	// Only render groups that were appended since the last update need a bottom level hierarchy.
+	for (unsigned int i = static_cast<unsigned int>(bottomLevelHierarchies.size()); i < scene.renderGroups.size(); ++i) {
+		const auto & primitives = scene.renderGroups[i].primitives;
+		std::vector<AABB> primitiveBounds(primitives.size());
+		for (unsigned int j = 0; j < primitives.size(); ++j) {
+			primitiveBounds[j] = primitives[j]->GetAxisAlignedBoundingBox();
+		}
+		BuildBottomLevel(primitiveBounds);
+
+		// Add the primitive references in leaf order.
+		auto & itemIndices = bottomLevelHierarchies.back().itemIndices;
+		renderGroupReferenceOffsets.push_back(static_cast<unsigned int>(primitiveReferences.size()));
+		for (unsigned int j = 0; j < itemIndices.size(); ++j) {
+			AddPrimitiveReference({ i, itemIndices[j] });
+			itemIndices[j] = j;
+		}
+	}
+	BuildTopLevel();
+}
+
+void TwoLevelBVHAccelerator::BuildBottomLevel(const std::vector<AABB> & primitiveBounds) {
+	bottomLevelHierarchies.push_back(BoundingVolumeHierarchy());
+	bottomLevelHierarchies.back().Build(primitiveBounds);
+}
+
+void TwoLevelBVHAccelerator::BuildTopLevel() {
+	topLevelRenderGroupIndices.clear();
+	std::vector<AABB> renderGroupBounds;
+	for (unsigned int i = 0; i < scene.renderGroups.size(); ++i) {
+		if (!scene.renderGroups[i].enabled || bottomLevelHierarchies[i].IsEmpty()) {
+			continue;
+		}
+		topLevelRenderGroupIndices.push_back(i);
+		renderGroupBounds.push_back(bottomLevelHierarchies[i].nodes[0].axisAlignedBoundingBox);
+	}
+	topLevelHierarchy.Build(renderGroupBounds);
+	topLevelHierarchy.ReorderItems(topLevelRenderGroupIndices);
+}
+
+bool TwoLevelBVHAccelerator::TraverseRenderGroup(const Ray & ray, const unsigned int renderGroupIndex, float & closestIntersectionDistance,
+												 unsigned int & intersectionPrimitiveIndex) const {
+	const unsigned int referenceOffset = renderGroupReferenceOffsets[renderGroupIndex];
+	return bottomLevelHierarchies[renderGroupIndex].Traverse(ray, closestIntersectionDistance, [&](unsigned int first, unsigned int count, float & closestDistance) {
+		return IntersectRenderGroupPrimitives(referenceOffset + first, count, ray, renderGroupIndex, closestDistance, intersectionPrimitiveIndex);
+	});
+}
+
+bool TwoLevelBVHAccelerator::IntersectRenderGroupPrimitives(const unsigned int first, const unsigned int count, const Ray & ray, const unsigned int renderGroupIndex,
+															float & closestIntersectionDistance, unsigned int & intersectionPrimitiveIndex) const {
+	// The render group itself is not checked here, since a render group ray cast ignores whether the render group is enabled.
+	const auto & primitives = scene.renderGroups[renderGroupIndex].primitives;
+	bool hit = false;
+	float intersectionDistances[PrimitiveBuffer::SIMD_WIDTH];
+	for (unsigned int i = first; i < first + count; i += PrimitiveBuffer::SIMD_WIDTH) {
+		const unsigned int width = std::min(PrimitiveBuffer::SIMD_WIDTH, first + count - i);
+		unsigned int mask = primitiveBuffer.RayIntersectionMask(i, width, ray, closestIntersectionDistance, intersectionDistances);
+		for (unsigned int lane = 0; mask != 0; ++lane, mask >>= 1) {
+			const unsigned int primitiveIndex = primitiveReferences[i + lane].primitiveIndex;
+			if ((mask & 1) && intersectionDistances[lane] < closestIntersectionDistance && primitives[primitiveIndex]->enabled) {
+				assert(intersectionDistances[lane] > FLT_EPSILON);
+				intersectionPrimitiveIndex = primitiveIndex;
+				closestIntersectionDistance = intersectionDistances[lane];
+				hit = true;
+			}
+		}
+	}
+	return hit;
+}
+
+bool TwoLevelBVHAccelerator::RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	float closestInterectionDistance = ray.tMax;
+	const bool hit = topLevelHierarchy.Traverse(ray, closestInterectionDistance, [&](unsigned int first, unsigned int count, float & closestDistance) {
+		bool leafHit = false;
+		for (unsigned int i = first; i < first + count; ++i) {
+			const unsigned int renderGroupIndex = topLevelRenderGroupIndices[i];
+			if (TraverseRenderGroup(ray, renderGroupIndex, closestDistance, intersectionPrimitiveIndex)) {
+				intersectionRenderGroupIndex = renderGroupIndex;
+				leafHit = true;
+			}
+		}
+		return leafHit;
+	});
+	intersectionDistance = hit ? closestInterectionDistance : FLT_MAX;
+	return hit;
+}
+
+bool TwoLevelBVHAccelerator::Occluded(const Ray & ray, const float tMax) const {
+	return topLevelHierarchy.TraverseAny(ray, tMax, [&](unsigned int first, unsigned int count) {
+		for (unsigned int i = first; i < first + count; ++i) {
+			const unsigned int renderGroupIndex = topLevelRenderGroupIndices[i];
+			const unsigned int referenceOffset = renderGroupReferenceOffsets[renderGroupIndex];
+			if (bottomLevelHierarchies[renderGroupIndex].TraverseAny(ray, tMax, [&](unsigned int first, unsigned int count) {
+				return PrimitivesOcclude(referenceOffset + first, count, ray, tMax);
+			})) {
+				return true;
+			}
+		}
+		return false;
+	});
+}
+
+bool TwoLevelBVHAccelerator::RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	float closestInterectionDistance = ray.tMax;
+	const bool hit = TraverseRenderGroup(ray, renderGroupIndex, closestInterectionDistance, intersectionPrimitiveIndex);
+	intersectionDistance = hit ? closestInterectionDistance : FLT_MAX;
+	return hit;
+}
+
+void TwoLevelBVHAccelerator::RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const {
+	topLevelHierarchy.TraverseAny(ray, ray.tMax, [&](unsigned int first, unsigned int count) {
+		for (unsigned int i = first; i < first + count; ++i) {
+			const unsigned int renderGroupIndex = topLevelRenderGroupIndices[i];
+			const unsigned int referenceOffset = renderGroupReferenceOffsets[renderGroupIndex];
+			bottomLevelHierarchies[renderGroupIndex].TraverseAny(ray, ray.tMax, [&](unsigned int first, unsigned int count) {
+				for (unsigned int j = referenceOffset + first; j < referenceOffset + first + count; ++j) {
+					AppendPrimitiveIntersections(j, ray, intersections);
+				}
+				return false; // Keep traversing.
+			});
+		}
+		return false;
+	});
+}
+
+void TwoLevelBVHAccelerator::RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const {
+	float closestIntersectionDistances[MAX_PACKET_SIZE];
+	for (unsigned int i = 0; i < count; ++i) {
+		closestIntersectionDistances[i] = rays[i].tMax;
+	}
+
+	// The rays which reach a top level leaf continue through the bottom level hierarchies as a packet.
+	topLevelHierarchy.TraversePacket(rays, count, closestIntersectionDistances, [&](unsigned int first, unsigned int itemCount, unsigned int firstRay) {
+		for (unsigned int i = first; i < first + itemCount; ++i) {
+			const unsigned int renderGroupIndex = topLevelRenderGroupIndices[i];
+			const unsigned int referenceOffset = renderGroupReferenceOffsets[renderGroupIndex];
+			bottomLevelHierarchies[renderGroupIndex].TraversePacket(rays + firstRay, count - firstRay, closestIntersectionDistances + firstRay,
+																   [&](unsigned int first, unsigned int itemCount, unsigned int firstBottomLevelRay) {
+				for (unsigned int j = firstRay + firstBottomLevelRay; j < count; ++j) {
+					if (IntersectRenderGroupPrimitives(referenceOffset + first, itemCount, rays[j], renderGroupIndex, closestIntersectionDistances[j],
+													   intersections[j].primitiveIndex)) {
+						intersections[j].renderGroupIndex = renderGroupIndex;
+					}
+				}
+			});
+		}
+	});
+
+	for (unsigned int i = 0; i < count; ++i) {
+		intersections[i].distance = closestIntersectionDistances[i] < rays[i].tMax ? closestIntersectionDistances[i] : FLT_MAX;
+	}
+}
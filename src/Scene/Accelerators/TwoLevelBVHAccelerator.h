@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Accelerator.h"
+#include "../BoundingVolumeHierarchy.h"
+
+/// <summary>
+/// Acceleration structure using a top level bounding volume hierarchy over the render groups
+/// and one bottom level bounding volume hierarchy over the primitives of every render group.
+/// Enabling, disabling or appending render groups only requires the (small) top level to be rebuilt.
+/// </summary>
+class TwoLevelBVHAccelerator : public Accelerator {
+public:
+	TwoLevelBVHAccelerator(const class Scene & scene);
+	bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const override;
+	bool Occluded(const Ray & ray, const float tMax) const override;
+	void RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const override;
+	void RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const override;
+	bool RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const override;
+	void UpdateRenderGroups() override;
+protected:
+	void BuildStructure(const std::vector<AABB> & primitiveBounds) override;
+private:
+	/// <summary> 
+	/// The bottom level hierarchies. Item i of hierarchy j is primitive reference i of render group j. 
+	/// The item indices are the identity, since the primitive references are stored in leaf order.
+	/// </summary>
+	std::vector<BoundingVolumeHierarchy> bottomLevelHierarchies;
+
+	/// <summary> 
+	/// The index of the first primitive reference of every render group. 
+	/// The primitive references of a render group are contiguous and ordered like the leaves of its bottom level hierarchy.
+	/// </summary>
+	std::vector<unsigned int> renderGroupReferenceOffsets;
+
+	/// <summary> The top level hierarchy over all enabled (non-empty) render groups. </summary>
+	BoundingVolumeHierarchy topLevelHierarchy;
+
+	/// <summary> The render group index of every item in the top level hierarchy. </summary>
+	std::vector<unsigned int> topLevelRenderGroupIndices;
+
+	/// <summary> Builds the bottom level hierarchy of the next render group given the bounding boxes of its primitives. </summary>
+	void BuildBottomLevel(const std::vector<AABB> & primitiveBounds);
+
+	/// <summary> Builds the top level hierarchy over the bounding boxes of all enabled render groups. </summary>
+	void BuildTopLevel();
+
+	/// <summary>
+	/// Traverses the bottom level hierarchy of a render group.
+	/// Returns true (and updates the closest intersection) if a primitive is hit closer than the closest intersection.
+	/// </summary>
+	bool TraverseRenderGroup(const Ray & ray, const unsigned int renderGroupIndex, float & closestIntersectionDistance,
+							 unsigned int & intersectionPrimitiveIndex) const;
+
+	/// <summary>
+	/// Intersects the primitive references [first, first + count) of a render group, ignoring whether the render group is enabled.
+	/// Returns true (and updates the closest intersection) if a primitive is hit closer than the closest intersection.
+	/// </summary>
+	bool IntersectRenderGroupPrimitives(const unsigned int first, const unsigned int count, const Ray & ray, const unsigned int renderGroupIndex,
+										float & closestIntersectionDistance, unsigned int & intersectionPrimitiveIndex) const;
+};
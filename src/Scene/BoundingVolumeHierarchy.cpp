@@ -0,0 +1,184 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+
+#define __BVH_BIN_COUNT 12 // The number of bins used per axis when evaluating the SAH.
+#define __BVH_MAX_LEAF_SIZE 4 // Leaves are always split when they contain more items than this.
+#define __BVH_TRAVERSAL_COST 1.0f // The cost of traversing a node relative to intersecting an item.
+#define __BVH_MAX_SAH_DEPTH 32 // Deeper nodes are split at their median item, which adds at most 32 more levels.
+
+namespace {
+	// Grows an AABB so that it contains another AABB.
+	void Grow(AABB & aabb, const AABB & other) {
+		aabb.minimum = glm::min(aabb.minimum, other.minimum);
+		aabb.maximum = glm::max(aabb.maximum, other.maximum);
+	}
+
+	// Returns an "empty" AABB which can be grown.
+	AABB EmptyAABB() {
+		return AABB(glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+	}
+
+	// Returns the surface area of an AABB (0 for empty AABBs).
+	float SurfaceArea(const AABB & aabb) {
+		const glm::vec3 d = aabb.maximum - aabb.minimum;
+		if (d.x < 0.0f || d.y < 0.0f || d.z < 0.0f) {
+			return 0.0f;
+		}
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	struct Bin {
+		AABB axisAlignedBoundingBox = EmptyAABB();
+		unsigned int count = 0;
+	};
+}
+
+void BoundingVolumeHierarchy::Build(const std::vector<AABB> & bounds) {
+	nodes.clear();
+	itemIndices.resize(bounds.size());
+	std::iota(itemIndices.begin(), itemIndices.end(), 0);
+	if (bounds.empty()) {
+		return;
+	}
+
+	std::vector<glm::vec3> centroids(bounds.size());
+	for (unsigned int i = 0; i < bounds.size(); ++i) {
+		centroids[i] = bounds[i].GetCenter();
+	}
+
+	nodes.reserve(2 * bounds.size());
+	BuildRecursive(bounds, centroids, 0, static_cast<unsigned int>(bounds.size()), 0);
+}
+
+unsigned int BoundingVolumeHierarchy::BuildRecursive(const std::vector<AABB> & bounds, const std::vector<glm::vec3> & centroids,
+													 unsigned int begin, unsigned int end, unsigned int depth) {
+	assert(depth <= MAX_DEPTH);
+	const unsigned int nodeIndex = static_cast<unsigned int>(nodes.size());
+	nodes.push_back(Node());
+
+	// Compute the bounds of the node and the bounds of the item centroids.
+	AABB nodeBounds = EmptyAABB();
+	AABB centroidBounds = EmptyAABB();
+	for (unsigned int i = begin; i < end; ++i) {
+		const unsigned int item = itemIndices[i];
+		Grow(nodeBounds, bounds[item]);
+		Grow(centroidBounds, AABB(centroids[item], centroids[item]));
+	}
+	nodes[nodeIndex].axisAlignedBoundingBox = nodeBounds;
+
+	const unsigned int count = end - begin;
+	if (count == 1) {
+		nodes[nodeIndex].offset = begin;
+		nodes[nodeIndex].count = count;
+		return nodeIndex;
+	}
+
+	const glm::vec3 centroidExtent = centroidBounds.maximum - centroidBounds.minimum;
+	if (depth >= __BVH_MAX_SAH_DEPTH) {
+		// Split at the median item along the largest centroid extent, which halves the items on every level.
+		if (count <= __BVH_MAX_LEAF_SIZE) {
+			nodes[nodeIndex].offset = begin;
+			nodes[nodeIndex].count = count;
+			return nodeIndex;
+		}
+		const int axis = centroidExtent.x > centroidExtent.y ? (centroidExtent.x > centroidExtent.z ? 0 : 2) : (centroidExtent.y > centroidExtent.z ? 1 : 2);
+		const unsigned int middle = begin + count / 2;
+		std::nth_element(itemIndices.begin() + begin, itemIndices.begin() + middle, itemIndices.begin() + end, [&](unsigned int a, unsigned int b) {
+			return centroids[a][axis] < centroids[b][axis];
+		});
+		BuildRecursive(bounds, centroids, begin, middle, depth + 1);
+		nodes[nodeIndex].offset = BuildRecursive(bounds, centroids, middle, end, depth + 1);
+		nodes[nodeIndex].count = 0;
+		return nodeIndex;
+	}
+
+	// Find the best split using binned SAH over all three axes.
+	const float parentArea = SurfaceArea(nodeBounds);
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	unsigned int bestSplit = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		if (centroidExtent[axis] < FLT_EPSILON) {
+			continue; // All centroids are (more or less) on the same plane.
+		}
+
+		Bin bins[__BVH_BIN_COUNT];
+		const float scale = __BVH_BIN_COUNT / centroidExtent[axis];
+		for (unsigned int i = begin; i < end; ++i) {
+			const unsigned int item = itemIndices[i];
+			const int b = glm::min(__BVH_BIN_COUNT - 1, static_cast<int>((centroids[item][axis] - centroidBounds.minimum[axis]) * scale));
+			Grow(bins[b].axisAlignedBoundingBox, bounds[item]);
+			bins[b].count++;
+		}
+
+		// Sweep from the right to get the area and count of every right hand side.
+		float rightAreas[__BVH_BIN_COUNT - 1];
+		unsigned int rightCounts[__BVH_BIN_COUNT - 1];
+		AABB right = EmptyAABB();
+		unsigned int rightCount = 0;
+		for (int b = __BVH_BIN_COUNT - 1; b > 0; --b) {
+			Grow(right, bins[b].axisAlignedBoundingBox);
+			rightCount += bins[b].count;
+			rightAreas[b - 1] = SurfaceArea(right);
+			rightCounts[b - 1] = rightCount;
+		}
+
+		// Sweep from the left and evaluate the SAH for every split plane.
+		AABB left = EmptyAABB();
+		unsigned int leftCount = 0;
+		for (int b = 0; b < __BVH_BIN_COUNT - 1; ++b) {
+			Grow(left, bins[b].axisAlignedBoundingBox);
+			leftCount += bins[b].count;
+			if (leftCount == 0 || rightCounts[b] == 0) {
+				continue;
+			}
+			const float cost = SurfaceArea(left) * leftCount + rightAreas[b] * rightCounts[b];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	unsigned int middle;
+	if (bestAxis == -1) {
+		// No useful split plane was found (all centroids coincide).
+		if (count <= __BVH_MAX_LEAF_SIZE) {
+			nodes[nodeIndex].offset = begin;
+			nodes[nodeIndex].count = count;
+			return nodeIndex;
+		}
+		middle = begin + count / 2;
+	}
+	else {
+		// Create a leaf if that is cheaper than splitting.
+		const float splitCost = __BVH_TRAVERSAL_COST + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+		if (count <= __BVH_MAX_LEAF_SIZE && splitCost >= static_cast<float>(count)) {
+			nodes[nodeIndex].offset = begin;
+			nodes[nodeIndex].count = count;
+			return nodeIndex;
+		}
+
+		// Partition the items around the split plane.
+		const float scale = __BVH_BIN_COUNT / centroidExtent[bestAxis];
+		const float minimum = centroidBounds.minimum[bestAxis];
+		auto first = itemIndices.begin() + begin;
+		auto last = itemIndices.begin() + end;
+		middle = begin + static_cast<unsigned int>(std::partition(first, last, [&](unsigned int item) {
+			const int b = glm::min(__BVH_BIN_COUNT - 1, static_cast<int>((centroids[item][bestAxis] - minimum) * scale));
+			return b <= static_cast<int>(bestSplit);
+		}) - first);
+		assert(middle > begin && middle < end);
+	}
+
+	// Build the children. The first child is always placed directly after its parent.
+	BuildRecursive(bounds, centroids, begin, middle, depth + 1);
+	const unsigned int secondChild = BuildRecursive(bounds, centroids, middle, end, depth + 1);
+	nodes[nodeIndex].offset = secondChild;
+	nodes[nodeIndex].count = 0;
+	return nodeIndex;
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+
+#include <glm.hpp>
+
+#include "../Geometry/AABB.h"
+#include "../Geometry/Ray.h"
+
+/// <summary>
+/// A bounding volume hierarchy (BVH) built using the binned surface area heuristic (SAH).
+/// The hierarchy only knows about the bounding boxes of the items it is built over.
+/// Intersecting the items themselves is left to the caller (see Traverse).
+/// </summary>
+class BoundingVolumeHierarchy {
+public:
+	/// <summary> A node in the hierarchy. Nodes are stored in depth first order. </summary>
+	struct Node {
+		AABB axisAlignedBoundingBox;
+
+		/// <summary>
+		/// Leaves: index of the first item in the item index vector.
+		/// Interior nodes: index of the second child (the first child is always the next node).
+		/// </summary>
+		unsigned int offset;
+
+		/// <summary> The number of items in this node. Zero for interior nodes. </summary>
+		unsigned int count;
+
+		bool IsLeaf() const { return count > 0; }
+	};
+
+	/// <summary>
+	/// The largest depth of a node (the root has depth 0). The traversal stacks hold MAX_DEPTH + 1 entries, which is
+	/// enough since every level adds at most one entry. Build keeps every node above this depth (see BuildRecursive).
+	/// </summary>
+	static const unsigned int MAX_DEPTH = 64;
+
+	/// <summary> The nodes of the hierarchy. The root node is the first node. </summary>
+	std::vector<Node> nodes;
+
+	/// <summary> Indices of the items, ordered so that every leaf references a contiguous range. </summary>
+	std::vector<unsigned int> itemIndices;
+
+	/// <summary> Builds the hierarchy given the bounding boxes of all items. </summary>
+	/// <param name='bounds'> The bounding box of each item. Item i is referenced by index i. </param>
+	void Build(const std::vector<AABB> & bounds);
+
+	/// <summary> Returns true if the hierarchy does not contain any items. </summary>
+	bool IsEmpty() const { return nodes.empty(); }
+
+	/// <summary>
+	/// Reorders the given items into leaf order and resets the item indices to the identity.
+	/// Afterwards every leaf references a contiguous range of items, which is good for both caching and SIMD.
+	/// </summary>
+	/// <param name='items'> The items the hierarchy was built over. Item i is items[offset + i]. </param>
+	/// <param name='offset'> The index of the first item. </param>
+	template<typename Item>
+	void ReorderItems(std::vector<Item> & items, const unsigned int offset = 0);
+
+	/// <summary>
+	/// Traverses the hierarchy front to back and calls the given leaf function for every leaf
+	/// whose bounding box is hit by the ray (and is closer than the closest hit so far).
+	/// Returns true if the leaf function reported a hit.
+	/// </summary>
+	/// <param name='ray'> The ray which we traverse the hierarchy with. The ray data must be up to date. </param>
+	/// <param name='closestIntersectionDistance'>
+	/// IN/OUT: The distance to the closest hit. Leaves further away than this are skipped.
+	/// </param>
+	/// <param name='intersectLeaf'>
+	/// A function on the form bool(unsigned int first, unsigned int count, float & closestIntersectionDistance),
+	/// where [first, first + count) is the range of the leaf in the item index vector.
+	/// It should return true (and update the distance) if an item is hit closer than the given distance.
+	/// </param>
+	template<typename LeafFunction>
+	bool Traverse(const Ray & ray, float & closestIntersectionDistance, LeafFunction intersectLeaf) const;
+
+	/// <summary>
+	/// Traverses the hierarchy (in no particular order) and calls the given leaf function for every leaf
+	/// whose bounding box is hit by the ray closer than maxDistance. Stops as soon as the leaf function
+	/// reports a hit and then returns true. Used for any hit queries such as shadow rays.
+	/// </summary>
+	/// <param name='ray'> The ray which we traverse the hierarchy with. The ray data must be up to date. </param>
+	/// <param name='maxDistance'> Leaves further away than this are skipped. </param>
+	/// <param name='intersectLeaf'> A function on the form bool(unsigned int first, unsigned int count). See Traverse. </param>
+	template<typename LeafFunction>
+	bool TraverseAny(const Ray & ray, const float maxDistance, LeafFunction intersectLeaf) const;
+
+	/// <summary>
+	/// Traverses the hierarchy with a packet of coherent rays (such as camera rays), so that every node is only visited once 
+	/// for the whole packet. A node is visited if any ray in the packet hits it closer than that ray's closest hit so far.
+	/// Only the rays starting at the first ray which hits a node are tested further down the tree (see Wald et al., 
+	/// "Ray Tracing Deformable Scenes using Dynamic Bounding Volume Hierarchies", 2007).
+	/// </summary>
+	/// <param name='rays'> The rays of the packet. The ray data must be up to date. </param>
+	/// <param name='rayCount'> The number of rays in the packet. </param>
+	/// <param name='closestIntersectionDistances'> IN/OUT: The distance to the closest hit of every ray. </param>
+	/// <param name='intersectLeaf'>
+	/// A function on the form void(unsigned int first, unsigned int count, unsigned int firstRay), where [first, first + count) 
+	/// is the range of the leaf in the item index vector. It should intersect the rays [firstRay, rayCount) with the items, 
+	/// and update the closest distances of the rays which hit an item.
+	/// </param>
+	template<typename LeafFunction>
+	void TraversePacket(const Ray rays[], const unsigned int rayCount, float closestIntersectionDistances[], LeafFunction intersectLeaf) const;
+
+private:
+	/// <summary>
+	/// Recursively builds the subtree containing the items [begin, end). Returns the node index.
+	/// The SAH can split off one item at a time (for example with exponentially spaced items), so below a certain depth
+	/// nodes are split at their median item instead, which bounds the depth of the hierarchy by MAX_DEPTH.
+	/// </summary>
+	/// <param name='depth'> The depth of the subtree's root node. </param>
+	unsigned int BuildRecursive(const std::vector<AABB> & bounds, const std::vector<glm::vec3> & centroids,
+								unsigned int begin, unsigned int end, unsigned int depth);
+};
+
+template<typename Item>
+void BoundingVolumeHierarchy::ReorderItems(std::vector<Item> & items, const unsigned int offset) {
+	std::vector<Item> orderedItems(itemIndices.size());
+	for (unsigned int i = 0; i < itemIndices.size(); ++i) {
+		orderedItems[i] = items[offset + itemIndices[i]];
+		itemIndices[i] = i;
+	}
+	std::copy(orderedItems.begin(), orderedItems.end(), items.begin() + offset);
+}
+
+template<typename LeafFunction>
+bool BoundingVolumeHierarchy::Traverse(const Ray & ray, float & closestIntersectionDistance, LeafFunction intersectLeaf) const {
+	if (nodes.empty()) {
+		return false;
+	}
+
+	float entryDistance;
+	if (!nodes[0].axisAlignedBoundingBox.RayIntersection(ray, closestIntersectionDistance, entryDistance)) {
+		return false;
+	}
+
+	// Every stack entry also stores the entry distance of its node, so that nodes which are
+	// behind the closest hit found after they were pushed can be skipped.
+	std::pair<unsigned int, float> stack[MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	unsigned int nodeIndex = 0;
+	bool hit = false;
+
+	while (true) {
+		const Node & node = nodes[nodeIndex];
+		if (node.IsLeaf()) {
+			hit |= intersectLeaf(node.offset, node.count, closestIntersectionDistance);
+		}
+		else {
+			// Visit the child closest to the ray origin first.
+			unsigned int nearChild = nodeIndex + 1;
+			unsigned int farChild = node.offset;
+			float nearDistance, farDistance;
+			const bool hitNear = nodes[nearChild].axisAlignedBoundingBox.RayIntersection(ray, closestIntersectionDistance, nearDistance);
+			const bool hitFar = nodes[farChild].axisAlignedBoundingBox.RayIntersection(ray, closestIntersectionDistance, farDistance);
+			if (hitNear && hitFar) {
+				if (farDistance < nearDistance) {
+					std::swap(nearChild, farChild);
+					std::swap(nearDistance, farDistance);
+				}
+				assert(stackSize <= MAX_DEPTH);
+				stack[stackSize++] = std::make_pair(farChild, farDistance);
+				nodeIndex = nearChild;
+				continue;
+			}
+			if (hitNear) {
+				nodeIndex = nearChild;
+				continue;
+			}
+			if (hitFar) {
+				nodeIndex = farChild;
+				continue;
+			}
+		}
+		// Pop the next node which is still in front of the closest hit.
+		do {
+			if (stackSize == 0) {
+				return hit;
+			}
+			--stackSize;
+		} while (stack[stackSize].second > closestIntersectionDistance);
+		nodeIndex = stack[stackSize].first;
+	}
+}
+
+template<typename LeafFunction>
+bool BoundingVolumeHierarchy::TraverseAny(const Ray & ray, const float maxDistance, LeafFunction intersectLeaf) const {
+	float entryDistance;
+	if (nodes.empty() || !nodes[0].axisAlignedBoundingBox.RayIntersection(ray, maxDistance, entryDistance)) {
+		return false;
+	}
+
+	unsigned int stack[MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const Node & node = nodes[stack[--stackSize]];
+		if (node.IsLeaf()) {
+			if (intersectLeaf(node.offset, node.count)) {
+				return true;
+			}
+			continue;
+		}
+		const unsigned int firstChild = static_cast<unsigned int>(&node - &nodes[0]) + 1;
+		if (nodes[node.offset].axisAlignedBoundingBox.RayIntersection(ray, maxDistance, entryDistance)) {
+			assert(stackSize <= MAX_DEPTH);
+			stack[stackSize++] = node.offset;
+		}
+		if (nodes[firstChild].axisAlignedBoundingBox.RayIntersection(ray, maxDistance, entryDistance)) {
+			assert(stackSize <= MAX_DEPTH);
+			stack[stackSize++] = firstChild;
+		}
+	}
+	return false;
+}
+
+template<typename LeafFunction>
+void BoundingVolumeHierarchy::TraversePacket(const Ray rays[], const unsigned int rayCount, float closestIntersectionDistances[], LeafFunction intersectLeaf) const {
+	if (nodes.empty()) {
+		return;
+	}
+
+	// Every stack entry stores a node and the first ray which may hit it.
+	std::pair<unsigned int, unsigned int> stack[MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = std::make_pair(0u, 0u);
+
+	while (stackSize > 0) {
+		--stackSize;
+		const unsigned int nodeIndex = stack[stackSize].first;
+		unsigned int firstRay = stack[stackSize].second;
+		const Node & node = nodes[nodeIndex];
+
+		// Find the first ray which hits the node. The rays before it do not hit any of its descendants either.
+		float entryDistance;
+		while (firstRay < rayCount && !node.axisAlignedBoundingBox.RayIntersection(rays[firstRay], closestIntersectionDistances[firstRay], entryDistance)) {
+			++firstRay;
+		}
+		if (firstRay == rayCount) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			intersectLeaf(node.offset, node.count, firstRay);
+			continue;
+		}
+
+		// Visit the child closest to the ray origin first (the rays are coherent, so the first active ray decides).
+		unsigned int nearChild = nodeIndex + 1;
+		unsigned int farChild = node.offset;
+		const glm::vec3 centerOffset = nodes[farChild].axisAlignedBoundingBox.GetCenter() - nodes[nearChild].axisAlignedBoundingBox.GetCenter();
+		if (glm::dot(centerOffset, rays[firstRay].direction) < 0.0f) {
+			std::swap(nearChild, farChild);
+		}
+		assert(stackSize < MAX_DEPTH);
+		stack[stackSize++] = std::make_pair(farChild, firstRay);
+		stack[stackSize++] = std::make_pair(nearChild, firstRay);
+	}
+}
@@ -1,113 +1,148 @@
-#include "Scene.h"
-
-#include <memory>
-#include <algorithm>
-#include <cassert>
-#include <iostream>
-
-#include "../../includes/glm/gtx/norm.hpp"
-#include "../../includes/glm/gtx/rotate_vector.hpp"
-
-#include "../Rendering/Materials/LambertianMaterial.h"
-#include "../Geometry/Sphere.h"
-
-Scene::Scene() {}
-
-Scene::~Scene() {
-	for (auto& rg : renderGroups) {
-		for (auto primitive : rg.primitives) {
-			delete primitive;
-		}
-	}
-	for (auto m : materials) {
-		delete m;
-	}
-	delete photonMap;
-}
-
-Primitive & Scene::GetPrimitive(unsigned int renderGroupIndex, unsigned int primitiveIndex) {
-	assert(renderGroupIndex < renderGroups.size());
-	assert(primitiveIndex < renderGroups[renderGroupIndex].primitives.size());
-	return *(renderGroups[renderGroupIndex].primitives[primitiveIndex]);
-}
-
-void Scene::RecalculateAABB() {
-	glm::vec3 minimum = glm::vec3(FLT_MAX);
-	glm::vec3 maximum = glm::vec3(-FLT_MAX);
-	for (const auto & rg : renderGroups) {
-		const auto & aabb = rg.axisAlignedBoundingBox;
-		const auto & min = aabb.minimum;
-		const auto & max = aabb.maximum;
-		minimum.x = glm::min<float>(min.x, minimum.x);
-		minimum.y = glm::min<float>(min.y, minimum.y);
-		minimum.z = glm::min<float>(min.z, minimum.z);
-		maximum.x = glm::max<float>(max.x, maximum.x);
-		maximum.y = glm::max<float>(max.y, maximum.y);
-		maximum.z = glm::max<float>(max.z, maximum.z);
-	}
-	axisAlignedBoundingBox.minimum = minimum;
-	axisAlignedBoundingBox.maximum = maximum;
-}
-
-void Scene::Initialize() {
-	// Pre-store all emissive materials in a separate vector.
-	for (unsigned int i = 0; i < renderGroups.size(); ++i) {
-		if (renderGroups[i].material->IsEmissive()) {
-			emissiveRenderGroups.push_back(&renderGroups[i]);
-		}
-	}
-	RecalculateAABB();
-}
-
-bool Scene::RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
-
-	float closestInterectionDistance = FLT_MAX;
-
-	// Check if the ray intersects with any enabled render group in the scene.
-	// TODO: Use the octree to speed up performance by firstly ray casting on AABBs.
-	for (unsigned int i = 0; i < renderGroups.size(); ++i) {
-		if (!renderGroups[i].enabled) {
-			continue;
-		}
-		for (unsigned int j = 0; j < renderGroups[i].primitives.size(); ++j) {
-			if (!renderGroups[i].primitives[j]->enabled) {
-				continue;
-			}
-			bool intersects = renderGroups[i].primitives[j]->RayIntersection(ray, intersectionDistance);
-			if (intersects) {
-				assert(intersectionDistance > FLT_EPSILON);
-				if (intersectionDistance < closestInterectionDistance) {
-					intersectionRenderGroupIndex = i;
-					intersectionPrimitiveIndex = j;
-					closestInterectionDistance = intersectionDistance;
-				}
-			}
-		}
-	}
-
-	intersectionDistance = closestInterectionDistance;
-	return closestInterectionDistance < FLT_MAX - FLT_EPSILON;
-}
-
-bool Scene::RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
-	float closestInterectionDistance = FLT_MAX;
-
-	const auto & renderGroup = renderGroups[renderGroupIndex];
-
-	for (unsigned int j = 0; j < renderGroup.primitives.size(); ++j) {
-		if (!renderGroup.primitives[j]->enabled) {
-			continue;
-		}
-		bool intersects = renderGroup.primitives[j]->RayIntersection(ray, intersectionDistance);
-		if (intersects) {
-			assert(intersectionDistance > FLT_EPSILON);
-			if (intersectionDistance < closestInterectionDistance) {
-				intersectionPrimitiveIndex = j;
-				closestInterectionDistance = intersectionDistance;
-			}
-		}
-	}
-
-	intersectionDistance = closestInterectionDistance;
-	return closestInterectionDistance < FLT_MAX - FLT_EPSILON;
+#include "Scene.h"
+
+#include <memory>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <chrono>
+
+#include "../../includes/glm/gtx/norm.hpp"
+#include "../../includes/glm/gtx/rotate_vector.hpp"
+
+#include "../Rendering/Materials/LambertianMaterial.h"
+#include "../Geometry/Sphere.h"
+#include "Accelerators/BruteForceAccelerator.h"
+#include "Accelerators/OctreeAccelerator.h"
+#include "Accelerators/BVHAccelerator.h"
+#include "Accelerators/TwoLevelBVHAccelerator.h"
+
+Scene::Scene() {}
+
+Scene::~Scene() {
+	for (auto& rg : renderGroups) {
+		for (auto primitive : rg.primitives) {
+			delete primitive;
+		}
+	}
+	for (auto m : materials) {
+		delete m;
+	}
+	delete photonMap;
+	delete accelerator;
+}
+
+Primitive & Scene::GetPrimitive(unsigned int renderGroupIndex, unsigned int primitiveIndex) {
+	assert(renderGroupIndex < renderGroups.size());
+	assert(primitiveIndex < renderGroups[renderGroupIndex].primitives.size());
+	return *(renderGroups[renderGroupIndex].primitives[primitiveIndex]);
+}
+
+void Scene::RecalculateAABB() {
+	glm::vec3 minimum = glm::vec3(FLT_MAX);
+	glm::vec3 maximum = glm::vec3(-FLT_MAX);
+	for (const auto & rg : renderGroups) {
+		const auto & aabb = rg.axisAlignedBoundingBox;
+		const auto & min = aabb.minimum;
+		const auto & max = aabb.maximum;
+		minimum.x = glm::min<float>(min.x, minimum.x);
+		minimum.y = glm::min<float>(min.y, minimum.y);
+		minimum.z = glm::min<float>(min.z, minimum.z);
+		maximum.x = glm::max<float>(max.x, maximum.x);
+		maximum.y = glm::max<float>(max.y, maximum.y);
+		maximum.z = glm::max<float>(max.z, maximum.z);
+	}
+	axisAlignedBoundingBox.minimum = minimum;
+	axisAlignedBoundingBox.maximum = maximum;
+}
+
+void Scene::CollectEmissiveRenderGroups() {
+	// Pre-store all emissive materials in a separate vector.
+	emissiveRenderGroups.clear();
+	for (unsigned int i = 0; i < renderGroups.size(); ++i) {
+		if (renderGroups[i].material->IsEmissive()) {
+			renderGroups[i].RecalculateArea();
+			emissiveRenderGroups.push_back(&renderGroups[i]);
+		}
+	}
+}
+
+void Scene::Initialize(const AcceleratorType acceleratorType) {
+	CollectEmissiveRenderGroups();
+	RecalculateAABB();
+	SetAccelerator(acceleratorType);
+}
+
+void Scene::UpdateRenderGroups() {
+	// Appending render groups may have moved the render group vector.
+	CollectEmissiveRenderGroups();
+	RecalculateAABB();
+	accelerator->UpdateRenderGroups();
+}
+
+void Scene::SetAccelerator(const AcceleratorType acceleratorType) {
+	delete accelerator;
+	switch (acceleratorType) {
+	case AcceleratorType::BRUTE_FORCE:
+		accelerator = new BruteForceAccelerator(*this);
+		break;
+	case AcceleratorType::OCTREE:
+		accelerator = new OctreeAccelerator(*this);
+		break;
+	case AcceleratorType::BOUNDING_VOLUME_HIERARCHY:
+		accelerator = new BVHAccelerator(*this);
+		break;
+	case AcceleratorType::TWO_LEVEL_BOUNDING_VOLUME_HIERARCHY:
+		accelerator = new TwoLevelBVHAccelerator(*this);
+		break;
+	}
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	accelerator->Build();
+	const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime).count();
+	std::cout << "Built the " << accelerator->ACCELERATOR_NAME << " acceleration structure in " << took << " ms." << std::endl;
+}
+
+bool Scene::RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	// Rays that miss the whole scene can be rejected immediately.
+	if (!axisAlignedBoundingBox.RayIntersection(ray)) {
+		intersectionDistance = FLT_MAX;
+		return false;
+	}
+	return accelerator->RayCast(ray, intersectionRenderGroupIndex, intersectionPrimitiveIndex, intersectionDistance);
+}
+
+bool Scene::Occluded(const Ray & ray, const float tMax) const {
+	if (!axisAlignedBoundingBox.RayIntersection(ray)) {
+		return false;
+	}
+	return accelerator->Occluded(ray, glm::min(tMax, ray.tMax));
+}
+
+void Scene::RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const {
+	intersections.clear();
+	if (!axisAlignedBoundingBox.RayIntersection(ray)) {
+		return;
+	}
+	accelerator->RayCastAll(ray, intersections);
+
+	// Sort by distance and remove intersections reported more than once by the acceleration structure.
+	std::sort(intersections.begin(), intersections.end(), [](const Intersection & a, const Intersection & b) {
+		if (a.distance != b.distance) {
+			return a.distance < b.distance;
+		}
+		return a.renderGroupIndex != b.renderGroupIndex ? a.renderGroupIndex < b.renderGroupIndex : a.primitiveIndex < b.primitiveIndex;
+	});
+	intersections.erase(std::unique(intersections.begin(), intersections.end(), [](const Intersection & a, const Intersection & b) {
+		return a.distance == b.distance && a.renderGroupIndex == b.renderGroupIndex && a.primitiveIndex == b.primitiveIndex;
+	}), intersections.end());
+}
+
+void Scene::RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const {
+	for (unsigned int i = 0; i < count; i += Accelerator::MAX_PACKET_SIZE) {
+		accelerator->RayCastPacket(rays + i, std::min(Accelerator::MAX_PACKET_SIZE, count - i), intersections + i);
+	}
+}
+
+bool Scene::RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const {
+	return accelerator->RenderGroupRayCast(ray, renderGroupIndex, intersectionPrimitiveIndex, intersectionDistance);
 }
\ No newline at end of file
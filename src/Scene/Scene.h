@@ -1,68 +1,116 @@
-#pragma once
-
-#include <vector>
-#include <functional>
-
-#include <glm.hpp>
-
-#include "../Geometry/Ray.h"
-#include "../Rendering/RenderGroup.h"
-#include "../Geometry/Triangle.h"
-#include "../PhotonMap/PhotonMap.h"
-#include "../Geometry/AABB.h"
-
-class Scene {
-public:
-	/// <summary> The groups in this scene which are renderable. </summary>
-	std::vector<RenderGroup> renderGroups;
-	std::vector<Material*> materials;
-	std::vector<RenderGroup*> emissiveRenderGroups;
-
-	/// <summary> Boundaries of the scene. </summary>
-	AABB axisAlignedBoundingBox;
-
-	/// <summary> Photon Map. </summary>
-	PhotonMap* photonMap = nullptr;
-
-	/// <summary> Call this after all primitives has been added to the scene (pre-render). </summary>
-	void Initialize();
-
-	Scene();
-	~Scene();
-
-	/// <summary> Returns a primitive given it's render group index and primitive index. </summary>
-	Primitive & GetPrimitive(unsigned int renderGroupIndex, unsigned int primitiveIndex);
-
-	void RecalculateAABB();
-
-	/// <summary> 
-	/// Casts a ray through the scene. Returns true if there was an intersection.
-	/// </summary>
-	/// <param name='ray'> The ray which we cast. </param>
-	/// <param name='intersectionRenderGroupIndex'> 
-	/// OUT: The intersection render group index if there was an intersection.
-	/// </param>
-	/// <param name='intersectionPrimitiveIndex'> 
-	/// OUT: The intersection primitive index if there was an intersection.
-	/// </param>
-	/// <param name='intersectionPoint'> 
-	/// OUT: The intersection point distance if there was an intersection.
-	/// </param>
-	bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const;
-
-	/// <summary> 
-	/// Casts a ray through a given render group. Returns true if there was an intersection.
-	/// </summary>
-	/// <param name='ray'> The ray which we cast. </param>
-	/// <param name='renderGroupIndex'> 
-	/// The intersection render group index which we ray cast at.
-	/// All other render groups are ignored!
-	/// </param>
-	/// <param name='intersectionPrimitiveIndex'> 
-	/// OUT: The intersection primitive index if there was an intersection.
-	/// </param>
-	/// <param name='intersectionPoint'> 
-	/// OUT: The intersection point distance if there was an intersection.
-	/// </param>
-	bool RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const;
+#pragma once
+
+#include <vector>
+#include <functional>
+
+#include <glm.hpp>
+
+#include "../Geometry/Ray.h"
+#include "../Rendering/RenderGroup.h"
+#include "../Geometry/Triangle.h"
+#include "../PhotonMap/PhotonMap.h"
+#include "../Geometry/AABB.h"
+#include "Accelerators/Accelerator.h"
+
+class Scene {
+public:
+	/// <summary> The groups in this scene which are renderable. </summary>
+	std::vector<RenderGroup> renderGroups;
+	std::vector<Material*> materials;
+	std::vector<RenderGroup*> emissiveRenderGroups;
+
+	/// <summary> Boundaries of the scene. </summary>
+	AABB axisAlignedBoundingBox;
+
+	/// <summary> Photon Map. </summary>
+	PhotonMap* photonMap = nullptr;
+
+	/// <summary> The acceleration structure used for ray casting. Created in Initialize(). </summary>
+	Accelerator* accelerator = nullptr;
+
+	/// <summary> Call this after all primitives has been added to the scene (pre-render). </summary>
+	/// <param name='acceleratorType'> The acceleration structure to use for ray casting. </param>
+	void Initialize(const AcceleratorType acceleratorType = AcceleratorType::TWO_LEVEL_BOUNDING_VOLUME_HIERARCHY);
+
+	Scene();
+	~Scene();
+
+	/// <summary> Returns a primitive given it's render group index and primitive index. </summary>
+	Primitive & GetPrimitive(unsigned int renderGroupIndex, unsigned int primitiveIndex);
+
+	void RecalculateAABB();
+
+	/// <summary> 
+	/// Replaces the acceleration structure used for ray casting with a new one of the given type.
+	/// Must be called (with the current type) if primitives are added or moved.
+	/// </summary>
+	void SetAccelerator(const AcceleratorType acceleratorType);
+
+	/// <summary> 
+	/// Call this after render groups have been enabled, disabled or appended to the scene (after Initialize).
+	/// Cheaper than SetAccelerator since only the parts of the acceleration structure that depend on the render groups are rebuilt.
+	/// </summary>
+	void UpdateRenderGroups();
+
+	/// <summary> 
+	/// Casts a ray through the scene. Returns true if there was an intersection.
+	/// </summary>
+	/// <param name='ray'> The ray which we cast. </param>
+	/// <param name='intersectionRenderGroupIndex'> 
+	/// OUT: The intersection render group index if there was an intersection.
+	/// </param>
+	/// <param name='intersectionPrimitiveIndex'> 
+	/// OUT: The intersection primitive index if there was an intersection.
+	/// </param>
+	/// <param name='intersectionPoint'> 
+	/// OUT: The intersection point distance if there was an intersection.
+	/// </param>
+	bool RayCast(const Ray & ray, unsigned int & intersectionRenderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const;
+
+	/// <summary> 
+	/// Returns true if the ray hits anything closer than tMax (or the ray's own tMax if that is closer).
+	/// Cheaper than RayCast since traversal stops at the first hit. Use this for shadow rays.
+	/// </summary>
+	/// <param name='ray'> The ray which we cast. </param>
+	/// <param name='tMax'> The distance along the ray to the point whose visibility we test. </param>
+	bool Occluded(const Ray & ray, const float tMax) const;
+
+	/// <summary> 
+	/// Casts a ray through the scene and finds all intersections within (ray.tMin, ray.tMax) in a single traversal.
+	/// A ray passing through a sphere intersects it twice.
+	/// </summary>
+	/// <param name='ray'> The ray which we cast. </param>
+	/// <param name='intersections'> OUT: All intersections, sorted by distance (closest first). </param>
+	void RayCastAll(const Ray & ray, std::vector<Intersection> & intersections) const;
+
+	/// <summary> 
+	/// Casts a packet of coherent rays (such as the camera rays of a pixel) through the scene. Gives the same result as
+	/// calling RayCast for every ray, but the acceleration structure may traverse the rays together.
+	/// </summary>
+	/// <param name='rays'> The rays which we cast. </param>
+	/// <param name='count'> The number of rays. </param>
+	/// <param name='intersections'> 
+	/// OUT: The closest intersection of every ray. The distance is FLT_MAX if the ray did not intersect anything.
+	/// </param>
+	void RayCastPacket(const Ray rays[], const unsigned int count, Intersection intersections[]) const;
+
+	/// <summary> 
+	/// Casts a ray through a given render group. Returns true if there was an intersection.
+	/// </summary>
+	/// <param name='ray'> The ray which we cast. </param>
+	/// <param name='renderGroupIndex'> 
+	/// The intersection render group index which we ray cast at.
+	/// All other render groups are ignored!
+	/// </param>
+	/// <param name='intersectionPrimitiveIndex'> 
+	/// OUT: The intersection primitive index if there was an intersection.
+	/// </param>
+	/// <param name='intersectionPoint'> 
+	/// OUT: The intersection point distance if there was an intersection.
+	/// </param>
+	bool RenderGroupRayCast(const Ray & ray, unsigned int renderGroupIndex, unsigned int & intersectionPrimitiveIndex, float & intersectionDistance) const;
+
+private:
+	/// <summary> Collects pointers to all emissive render groups into emissiveRenderGroups, and computes their areas. </summary>
+	void CollectEmissiveRenderGroups();
 };
\ No newline at end of file
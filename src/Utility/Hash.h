@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <glm.hpp>
+
+namespace Utility {
+	/// <summary>
+	/// An incremental 64-bit FNV-1a hash, used to identify scenes and settings (e.g. for cached photon maps).
+	/// Values are hashed by their bytes, so only scalars, vectors and strings should be added.
+	/// </summary>
+	class Hash {
+	public:
+		/// <summary> Adds raw bytes to the hash. </summary>
+		void Add(const void * data, const size_t size) {
+			const unsigned char * bytes = static_cast<const unsigned char *>(data);
+			for (size_t i = 0; i < size; ++i) {
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		}
+
+		/// <summary> Adds a scalar (or a string literal) to the hash. </summary>
+		template<typename T>
+		void Add(const T & value) {
+			Add(&value, sizeof(T));
+		}
+
+		/// <summary> Adds a vector to the hash. </summary>
+		void Add(const glm::vec3 & v) {
+			Add(v.x);
+			Add(v.y);
+			Add(v.z);
+		}
+
+		/// <summary> Returns the hash of everything added so far. </summary>
+		uint64_t Get() const { return hash; }
+
+	private:
+		uint64_t hash = 14695981039346656037ull;
+	};
+}
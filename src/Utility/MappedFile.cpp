@@ -0,0 +1,87 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+Utility::MappedFile::~MappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+bool Utility::MappedFile::Open(const std::string & path) {
+	Close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+	const void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = static_cast<const unsigned char *>(view);
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void Utility::MappedFile::Close() {
+	if (data != nullptr) {
+		UnmapViewOfFile(data);
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+	}
+	data = nullptr;
+	size = 0;
+	fileHandle = mappingHandle = nullptr;
+}
+#else
+bool Utility::MappedFile::Open(const std::string & path) {
+	Close();
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat fileStatus;
+	if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void * view = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file); // The mapping keeps the file open.
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	data = static_cast<const unsigned char *>(view);
+	size = static_cast<size_t>(fileStatus.st_size);
+	return true;
+}
+
+void Utility::MappedFile::Close() {
+	if (data != nullptr) {
+		munmap(const_cast<unsigned char *>(data), size);
+	}
+	data = nullptr;
+	size = 0;
+}
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace Utility {
+	/// <summary>
+	/// A read-only memory mapping of a whole file. The contents are paged in by the operating system on first use,
+	/// so large files (such as cached photon maps) can be used without reading or parsing them.
+	/// </summary>
+	class MappedFile {
+	public:
+		MappedFile() {}
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		/// <summary> Maps the given file (closing any previously mapped file). Returns false if the file could not be mapped. </summary>
+		bool Open(const std::string & path);
+
+		/// <summary> Unmaps the file. </summary>
+		void Close();
+
+		/// <summary> Returns the mapped contents, or nullptr if no file is mapped. </summary>
+		const unsigned char * GetData() const { return data; }
+
+		/// <summary> Returns the size of the mapped file in bytes. </summary>
+		size_t GetSize() const { return size; }
+
+	private:
+		const unsigned char * data = nullptr;
+		size_t size = 0;
+
+		/// <summary> The operating system handles of the file and the mapping (only used on Windows). </summary>
+		void * fileHandle = nullptr;
+		void * mappingHandle = nullptr;
+	};
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utility {
+	/// <summary>
+	/// A small and fast pseudo random number generator (PCG32, see O'Neill, "PCG: A Family of Simple Fast Space-Efficient
+	/// Statistically Good Algorithms for Random Number Generation", 2014). Unlike rand(), it has no shared state, so every
+	/// thread (or every sample) uses its own generator. Generators are seeded deterministically (e.g. by pixel and sample),
+	/// which makes renders reproducible regardless of the number of threads.
+	/// </summary>
+	class RandomGenerator {
+	public:
+		/// <param name='seed'> Selects the starting point of the sequence. Nearby seeds give uncorrelated sequences. </param>
+		/// <param name='sequence'> Selects one of 2^63 different sequences. </param>
+		RandomGenerator(const uint64_t seed = 0, const uint64_t sequence = 0) :
+			state(0), increment((sequence << 1) | 1) {
+			NextUInt();
+			state += Mix(seed);
+			NextUInt();
+		}
+
+		/// <summary> Returns a uniformly distributed 32-bit integer. </summary>
+		uint32_t NextUInt() {
+			const uint64_t oldState = state;
+			state = oldState * 6364136223846793005ull + increment;
+			const uint32_t xorShifted = static_cast<uint32_t>(((oldState >> 18) ^ oldState) >> 27);
+			const uint32_t rotation = static_cast<uint32_t>(oldState >> 59);
+			return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+		}
+
+		/// <summary> Returns a (practically) uniformly distributed integer in [0, n). Use instead of rand() % n. </summary>
+		uint32_t NextUInt(const uint32_t n) {
+			return static_cast<uint32_t>((static_cast<uint64_t>(NextUInt()) * n) >> 32);
+		}
+
+		/// <summary> Returns a uniformly distributed float in [0, 1). </summary>
+		float NextFloat() {
+			return static_cast<float>(NextUInt() >> 8) * (1.0f / 16777216.0f);
+		}
+
+	private:
+		uint64_t state, increment;
+
+		/// <summary> Scrambles a seed (SplitMix64 finalizer), so that consecutive seeds give unrelated states. </summary>
+		static uint64_t Mix(uint64_t x) {
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+			return x ^ (x >> 31);
+		}
+	};
+}
@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+Utility::ThreadPool::ThreadPool(const unsigned int threadCount) {
+	const unsigned int count = threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i < count; ++i) {
+		queues.emplace_back(new TaskQueue());
+	}
+	for (unsigned int i = 1; i < count; ++i) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+Utility::ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	batchStarted.notify_all();
+	for (auto & worker : workers) {
+		worker.join();
+	}
+}
+
+void Utility::ThreadPool::Run(const unsigned int taskCount, const Task & task) {
+	// Distribute the tasks round robin, so that neighbouring (often similarly expensive) tasks start on different threads.
+	const unsigned int threadCount = GetThreadCount();
+	for (unsigned int i = 0; i < taskCount; ++i) {
+		TaskQueue & queue = *queues[i % threadCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(i);
+	}
+
+	// Wake up the workers and help out.
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		busyWorkers = threadCount - 1;
+		++batch;
+	}
+	batchStarted.notify_all();
+	RunTasks(task, 0);
+
+	// Wait for the tasks which are still running on other threads.
+	std::unique_lock<std::mutex> lock(mutex);
+	batchFinished.wait(lock, [&] { return busyWorkers == 0; });
+	currentTask = nullptr;
+}
+
+void Utility::ThreadPool::WorkerLoop(const unsigned int threadIndex) {
+	unsigned int lastBatch = 0;
+	while (true) {
+		const Task * task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			batchStarted.wait(lock, [&] { return stopping || batch != lastBatch; });
+			if (stopping) {
+				return;
+			}
+			lastBatch = batch;
+			task = currentTask;
+		}
+
+		RunTasks(*task, threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--busyWorkers;
+		}
+		batchFinished.notify_one();
+	}
+}
+
+void Utility::ThreadPool::RunTasks(const Task & task, const unsigned int threadIndex) {
+	unsigned int taskIndex;
+	while (TakeTask(threadIndex, taskIndex)) {
+		task(taskIndex, threadIndex);
+	}
+}
+
+bool Utility::ThreadPool::TakeTask(const unsigned int threadIndex, unsigned int & taskIndex) {
+	const unsigned int threadCount = GetThreadCount();
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		TaskQueue & queue = *queues[(threadIndex + i) % threadCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty()) {
+			continue;
+		}
+		// Take our own tasks in order, but steal from the back of the other queues.
+		if (i == 0) {
+			taskIndex = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		else {
+			taskIndex = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+namespace Utility {
+	/// <summary>
+	/// A persistent pool of worker threads which run batches of independent tasks (such as image tiles).
+	/// Every thread has its own task queue. A thread which runs out of tasks steals tasks from the other queues,
+	/// so that expensive tasks do not leave the other threads idle.
+	/// </summary>
+	class ThreadPool {
+	public:
+		/// <summary> A task on the form void(unsigned int taskIndex, unsigned int threadIndex). </summary>
+		typedef std::function<void(unsigned int, unsigned int)> Task;
+
+		/// <summary> Starts the worker threads. </summary>
+		/// <param name='threadCount'>
+		/// The number of threads (including the thread calling Run). Uses all hardware threads if 0.
+		/// </param>
+		ThreadPool(const unsigned int threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+		/// <summary> Returns the number of threads (including the thread calling Run). </summary>
+		unsigned int GetThreadCount() const { return static_cast<unsigned int>(queues.size()); }
+
+		/// <summary>
+		/// Runs task(taskIndex, threadIndex) for every task index in [0, taskCount) and returns when all tasks are finished.
+		/// The calling thread works on the tasks as thread 0. The tasks are started in roughly increasing order.
+		/// </summary>
+		void Run(const unsigned int taskCount, const Task & task);
+
+	private:
+		/// <summary> The tasks of a thread. The owner takes tasks from the front, thieves from the back. </summary>
+		struct TaskQueue {
+			std::mutex mutex;
+			std::deque<unsigned int> tasks;
+		};
+
+		std::vector<std::unique_ptr<TaskQueue>> queues;
+		std::vector<std::thread> workers;
+
+		/// <summary> Guards the state below, which is used to start and finish batches of tasks. </summary>
+		std::mutex mutex;
+		std::condition_variable batchStarted, batchFinished;
+		const Task * currentTask = nullptr;
+		unsigned int batch = 0, busyWorkers = 0;
+		bool stopping = false;
+
+		/// <summary> The main loop of worker thread threadIndex (1 or higher). </summary>
+		void WorkerLoop(const unsigned int threadIndex);
+
+		/// <summary> Runs tasks (own tasks first, then stolen tasks) until all queues are empty. </summary>
+		void RunTasks(const Task & task, const unsigned int threadIndex);
+
+		/// <summary> Takes the next task for the given thread. Returns false if all queues are empty. </summary>
+		bool TakeTask(const unsigned int threadIndex, unsigned int & taskIndex);
+	};
+}